@@ -0,0 +1,109 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+
+// This example compares the two estimators of the model coverage (i.e., the area of a candidate 
+// face covered by its supporting points): the alpha shapes and the raster occupancy grids. For 
+// each estimator, it reports the running time and (for the raster) how much the covered areas 
+// differ from the ones given by the alpha shapes.
+
+#include <basic/logger.h>
+#include <basic/stop_watch.h>
+#include <model/point_set.h>
+#include <model/map.h>
+#include <model/point_set_io.h>
+#include <model/map_attributes.h>
+#include <method/hypothesis_generator.h>
+#include <method/method_global.h>
+
+#include <cmath>
+
+
+// computes the face confidences using 'estimator' and returns the covered area of each face
+static double run(HypothesisGenerator& hypothesis, Map* mesh, HypothesisGenerator::CoverageEstimator estimator, std::vector<double>& covered) {
+    hypothesis.set_coverage_estimator(estimator);
+
+    StopWatch w;
+    hypothesis.compute_confidences(mesh, false);
+    double time = w.elapsed();
+
+    covered.clear();
+    MapFacetAttribute<double> covered_area(mesh, Method::facet_attrib_covered_area);
+    FOR_EACH_FACET(Map, mesh, it)
+        covered.push_back(covered_area[it]);
+    return time;
+}
+
+
+int main(int argc, char **argv)
+{
+    // initialize the logger (this is not optional)
+    Logger::initialize();
+
+    // input point cloud file name
+    const std::string input_file = (argc > 1) ? argv[1] : std::string(POLYFIT_ROOT_DIR) + "/data/toy_data.bvg";
+
+    // load point cloud from file
+    PointSet* point_cloud = PointSetIO::read(input_file);
+    if (!point_cloud) {
+        std::cerr << "failed loading point cloud from file: " << input_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (point_cloud->groups().empty()) {
+        std::cerr << "planar segments do not exist" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    HypothesisGenerator hypothesis(point_cloud);
+    hypothesis.refine_planes();
+    Map* mesh = hypothesis.generate();
+    if (!mesh) {
+        std::cerr << "failed generating candidate faces. Please check if the input point cloud has good planar segments" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // NOTE: the times include the point confidences, which are the same for both estimators
+    std::vector<double> alpha_covered, raster_covered;
+    double alpha_time = run(hypothesis, mesh, HypothesisGenerator::ALPHA_SHAPE, alpha_covered);
+    double raster_time = run(hypothesis, mesh, HypothesisGenerator::RASTER, raster_covered);
+
+    MapFacetAttribute<double> facet_area(mesh, Method::facet_attrib_facet_area);
+    double total_area = 0, alpha_total = 0, raster_total = 0, total_difference = 0, max_difference = 0;
+    std::size_t idx = 0;
+    FOR_EACH_FACET(Map, mesh, it) {
+        double area = facet_area[it];
+        double difference = std::fabs(raster_covered[idx] - alpha_covered[idx]);
+        total_area += area;
+        alpha_total += alpha_covered[idx];
+        raster_total += raster_covered[idx];
+        total_difference += difference;
+        if (area > 0)
+            max_difference = std::max(max_difference, difference / area);
+        ++idx;
+    }
+
+    std::cout << "candidate faces: " << mesh->size_of_facets() << ", total area: " << total_area << std::endl;
+    std::cout << "alpha shape: " << alpha_time << " sec, covered area: " << alpha_total << std::endl;
+    std::cout << "raster:      " << raster_time << " sec, covered area: " << raster_total << std::endl;
+    if (total_area > 0) {
+        std::cout << "difference (relative to the total face area): " << total_difference / total_area * 100.0 << "%" << std::endl;
+        std::cout << "max difference (relative to the face area): " << max_difference * 100.0 << "%" << std::endl;
+    }
+
+    delete mesh;
+    delete point_cloud;
+    return EXIT_SUCCESS;
+}
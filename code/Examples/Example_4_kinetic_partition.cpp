@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+
+// This example is a scaling benchmark of the two hypothesis generators: the arrangement of the planes
+// (i.e., generate()) and the kinetic partition (i.e., generate_kinetic()). Both are run on a growing 
+// number of the planar segments of the input (16, 32, 64, ... and all of them), and the running time, 
+// the number of candidate faces, and the number of variables of the face selection are reported. 
+// The arrangement is skipped when the number of planes exceeds a limit (the second argument).
+//
+// Usage: Example_4_kinetic_partition [point cloud file] [max number of planes for generate()]
+
+#include <basic/logger.h>
+#include <basic/stop_watch.h>
+#include <model/point_set.h>
+#include <model/map.h>
+#include <model/point_set_io.h>
+#include <method/hypothesis_generator.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+struct Result {
+    double      time;
+    std::size_t num_faces;
+    std::size_t num_variables;  // faces + 2 * usable edges (usage and sharpness) of the face selection
+
+    Result() : time(0), num_faces(0), num_variables(0) {}
+};
+
+
+static bool run(PointSet* pset, bool kinetic, Result& result) {
+    HypothesisGenerator hypothesis(pset);
+    hypothesis.set_num_threads(0);
+
+    StopWatch w;
+    Map* mesh = kinetic ? hypothesis.generate_kinetic() : hypothesis.generate();
+    result.time = w.elapsed();
+    if (!mesh)
+        return false;
+
+    result.num_faces = mesh->size_of_facets();
+    HypothesisGenerator::Adjacency adjacency = hypothesis.extract_adjacency(mesh);
+    std::size_t num_edges = 0;
+    for (std::size_t i = 0; i < adjacency.size(); ++i) {
+        if (adjacency.usable(i))
+            ++num_edges;
+    }
+    result.num_variables = result.num_faces + 2 * num_edges;
+
+    delete mesh;
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    // initialize the logger (this is not optional)
+    Logger::initialize();
+
+    // input point cloud file name
+    const std::string input_file = (argc > 1) ? argv[1] : std::string(POLYFIT_ROOT_DIR) + "/data/toy_data.bvg";
+    const std::size_t max_arrangement_planes = (argc > 2) ? std::atoi(argv[2]) : 500;
+
+    // load point cloud from file
+    PointSet* point_cloud = PointSetIO::read(input_file);
+    if (!point_cloud) {
+        std::cerr << "failed loading point cloud from file: " << input_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (point_cloud->groups().empty()) {
+        std::cerr << "planar segments do not exist" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // the subsets are the first planar segments of the input
+    const std::vector<VertexGroup::Ptr> all_groups = point_cloud->groups();
+    std::vector<std::size_t> sizes;
+    for (std::size_t n = 16; n < all_groups.size(); n *= 2)
+        sizes.push_back(n);
+    sizes.push_back(all_groups.size());
+
+    std::vector<Result> arrangement(sizes.size()), kinetic(sizes.size());
+    std::vector<bool> arrangement_done(sizes.size(), false);
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+        point_cloud->groups().assign(all_groups.begin(), all_groups.begin() + sizes[i]);
+
+        if (sizes[i] <= max_arrangement_planes)
+            arrangement_done[i] = run(point_cloud, false, arrangement[i]);
+        if (!run(point_cloud, true, kinetic[i])) {
+            std::cerr << "failed generating candidate faces. Please check if the input point cloud has good planar segments" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    point_cloud->groups() = all_groups;
+
+    std::printf("\n%8s | %28s | %28s\n", "", "arrangement", "kinetic");
+    std::printf("%8s | %8s %9s %9s | %8s %9s %9s\n", "planes", "sec", "faces", "variables", "sec", "faces", "variables");
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+        std::printf("%8zu | ", sizes[i]);
+        if (arrangement_done[i])
+            std::printf("%8.2f %9zu %9zu | ", arrangement[i].time, arrangement[i].num_faces, arrangement[i].num_variables);
+        else
+            std::printf("%8s %9s %9s | ", "-", "-", "-");
+        std::printf("%8.2f %9zu %9zu\n", kinetic[i].time, kinetic[i].num_faces, kinetic[i].num_variables);
+    }
+
+    delete point_cloud;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+
+// This example tunes the weights of the face selection using a checkpoint of the candidate faces. The
+// candidate faces and their confidences are computed only once (or not at all if the checkpoint file 
+// exists from a previous run). The face selection is formulated once for the reloaded candidate faces,
+// and each set of weights only changes the objective (the solver starts from the previous solution).
+//
+// Usage: Example_5_candidate_checkpoint [point cloud file] [checkpoint file]
+
+#include <basic/logger.h>
+#include <basic/stop_watch.h>
+#include <basic/file_utils.h>
+#include <model/point_set.h>
+#include <model/map.h>
+#include <model/point_set_io.h>
+#include <method/hypothesis_generator.h>
+#include <method/face_selection.h>
+
+
+int main(int argc, char **argv)
+{
+    // initialize the logger (this is not optional)
+    Logger::initialize();
+
+    // input point cloud file name
+    const std::string input_file = (argc > 1) ? argv[1] : std::string(POLYFIT_ROOT_DIR) + "/data/toy_data.bvg";
+    // checkpoint file name
+    const std::string checkpoint_file = (argc > 2) ? argv[2] : std::string(POLYFIT_ROOT_DIR) + "/data/toy_data-candidates.pfck";
+
+    // load point cloud from file
+    PointSet* point_cloud = PointSetIO::read(input_file);
+    if (!point_cloud) {
+        std::cerr << "failed loading point cloud from file: " << input_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (point_cloud->groups().empty()) {
+        std::cerr << "planar segments do not exist" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    HypothesisGenerator hypothesis(point_cloud);
+    if (!FileUtils::is_file(checkpoint_file)) {
+        StopWatch w;
+        hypothesis.refine_planes();
+        Map* mesh = hypothesis.generate();
+        if (!mesh) {
+            std::cerr << "failed generating candidate faces. Please check if the input point cloud has good planar segments" << std::endl;
+            return EXIT_FAILURE;
+        }
+        hypothesis.compute_confidences(mesh, false);
+        bool saved = hypothesis.save_candidates(mesh, checkpoint_file);
+        delete mesh;
+        if (!saved) {
+            std::cerr << "failed saving the candidate faces to file: " << checkpoint_file << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "candidate faces computed and saved: " << w.elapsed() << " sec" << std::endl;
+    }
+
+    // the weights: data fitting, model coverage, and model complexity
+    const double weights[][3] = {
+        { 0.43, 0.27, 0.3 },
+        { 0.6, 0.2, 0.2 },
+        { 0.3, 0.3, 0.4 }
+    };
+    StopWatch w;
+    Map* candidates = hypothesis.load_candidates(checkpoint_file);
+    if (!candidates || !hypothesis.ready_for_optimization(candidates)) {
+        std::cerr << "failed loading the candidate faces from file: " << checkpoint_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "candidate faces loaded: " << w.elapsed() << " sec" << std::endl;
+
+    // the binary program is formulated once, and only its objective changes with the weights
+    w.start();
+    FaceSelection selector(point_cloud, candidates);
+    // the first selection starts from a greedy closed surface (the log reports the time to the first 
+    // feasible solution, to compare with FaceSelection::NONE)
+    selector.set_initial_solution(FaceSelection::GREEDY);
+    if (!selector.formulate(&hypothesis)) {
+        std::cerr << "failed formulating the face selection" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "binary program formulated: " << w.elapsed() << " sec" << std::endl;
+
+    for (std::size_t i = 0; i < sizeof(weights) / sizeof(weights[0]); ++i) {
+        w.start();
+        Map* mesh = selector.select(LinearProgramSolver::SCIP, weights[i][0], weights[i][1], weights[i][2]);
+        if (!mesh) {
+            std::cerr << "face selection failed" << std::endl;
+            continue;
+        }
+        std::cout << "weights (" << weights[i][0] << ", " << weights[i][1] << ", " << weights[i][2] << "): "
+            << mesh->size_of_facets() << " faces. " << w.elapsed() << " sec optimization" << std::endl;
+        delete mesh;
+    }
+
+    delete candidates;
+    delete point_cloud;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+
+// This example checks that the candidate faces don't depend on the number of threads: the candidate 
+// faces are generated sequentially and with all the hardware threads, and the two meshes are compared
+// facet by facet (the facets are in the order of the variables of the face selection).
+//
+// Usage: Example_6_parallel_cut [point cloud file]
+
+#include <basic/logger.h>
+#include <basic/stop_watch.h>
+#include <model/point_set.h>
+#include <model/map.h>
+#include <model/map_attributes.h>
+#include <model/map_circulators.h>
+#include <model/point_set_io.h>
+#include <method/hypothesis_generator.h>
+
+#include <cstdlib>
+
+
+static Map* generate(PointSet* pset, int num_threads, double& time) {
+    HypothesisGenerator hypothesis(pset);
+    hypothesis.set_num_threads(num_threads);
+
+    StopWatch w;
+    Map* mesh = hypothesis.generate();
+    time = w.elapsed();
+    return mesh;
+}
+
+
+// returns the index of the first facet that differs (in its corners or its supporting plane), or -1
+static int first_difference(Map* mesh1, Map* mesh2) {
+    if (mesh1->size_of_facets() != mesh2->size_of_facets())
+        return 0;
+
+    MapFacetAttribute<Plane3d*> plane1(mesh1, "FacetSupportingPlane");
+    MapFacetAttribute<Plane3d*> plane2(mesh2, "FacetSupportingPlane");
+
+    int idx = 0;
+    Map::Facet_iterator it1 = mesh1->facets_begin();
+    Map::Facet_iterator it2 = mesh2->facets_begin();
+    for (; it1 != mesh1->facets_end(); ++it1, ++it2, ++idx) {
+        const Plane3d* p1 = plane1[it1];
+        const Plane3d* p2 = plane2[it2];
+        if (p1->a() != p2->a() || p1->b() != p2->b() || p1->c() != p2->c() || p1->d() != p2->d())
+            return idx;
+
+        FacetHalfedgeCirculator cir1(it1);
+        FacetHalfedgeCirculator cir2(it2);
+        for (; !cir1->end() && !cir2->end(); ++cir1, ++cir2) {
+            if (distance2(cir1->halfedge()->vertex()->point(), cir2->halfedge()->vertex()->point()) != 0)
+                return idx;
+        }
+        if (!cir1->end() || !cir2->end())
+            return idx;
+    }
+    return -1;
+}
+
+
+int main(int argc, char **argv)
+{
+    // initialize the logger (this is not optional)
+    Logger::initialize();
+
+    // input point cloud file name
+    const std::string input_file = (argc > 1) ? argv[1] : std::string(POLYFIT_ROOT_DIR) + "/data/toy_data.bvg";
+
+    // load point cloud from file
+    PointSet* point_cloud = PointSetIO::read(input_file);
+    if (!point_cloud) {
+        std::cerr << "failed loading point cloud from file: " << input_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (point_cloud->groups().empty()) {
+        std::cerr << "planar segments do not exist" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double sequential_time = 0, parallel_time = 0;
+    Map* sequential = generate(point_cloud, 1, sequential_time);
+    Map* parallel = generate(point_cloud, 0, parallel_time);
+    if (!sequential || !parallel) {
+        std::cerr << "failed generating candidate faces. Please check if the input point cloud has good planar segments" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "sequential: " << sequential->size_of_facets() << " faces. " << sequential_time << " sec" << std::endl;
+    std::cout << "parallel:   " << parallel->size_of_facets() << " faces. " << parallel_time << " sec" << std::endl;
+
+    int idx = first_difference(sequential, parallel);
+    if (idx >= 0)
+        std::cerr << "the candidate faces differ (from facet " << idx << ")" << std::endl;
+    else
+        std::cout << "the candidate faces are identical" << std::endl;
+
+    delete sequential;
+    delete parallel;
+    delete point_cloud;
+    return (idx >= 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -48,6 +48,7 @@ PaintCanvas::PaintCanvas(QWidget *parent)
 	, show_hint_text_(true)
 	, show_mouse_hint_(false)
 	, hypothesis_(nil)
+	, selection_(nil)
 {
 	setFPSIsDisplayed(true);
 
@@ -87,6 +88,11 @@ void PaintCanvas::clear() {
 	if (point_set_)
 		point_set_.forget();
 
+	if (selection_) {
+		delete selection_;
+		selection_ = nil;
+	}
+
 	if (hypothesis_mesh_)
 		hypothesis_mesh_.forget();
 
@@ -477,6 +483,10 @@ void PaintCanvas::refinePlanes() {
 
 	main_window_->disableActions(true);
 
+	if (selection_) {
+		delete selection_;
+		selection_ = nil;
+	}
 
 	if (hypothesis_)
 		delete hypothesis_;
@@ -516,6 +526,11 @@ void PaintCanvas::generateFacetHypothesis() {
 
 	Logger::out("-") << "generating plane hypothesis..." << std::endl;
 
+	if (selection_) {
+		delete selection_;
+		selection_ = nil;
+	}
+
 	StopWatch w;
 	hypothesis_mesh_ = hypothesis_->generate();
 	if (hypothesis_mesh_) {
@@ -562,6 +577,12 @@ void PaintCanvas::generateQualityMeasures() {
 	}
 
 	main_window_->disableActions(true);
+
+	// the objective of the face selection depends on the confidences
+	if (selection_) {
+		delete selection_;
+		selection_ = nil;
+	}
 	
 	hypothesis_->compute_confidences(hypothesis_mesh_, false);
 
@@ -603,20 +624,38 @@ void PaintCanvas::optimization() {
 
 	main_window_->updateWeights();
 	main_window_->disableActions(true);
-	Map* mesh = Geom::duplicate(hypothesis_mesh_);
 
-	FaceSelection selector(point_set_, mesh);
-    selector.optimize(hypothesis_,
-                      main_window_->active_solver(),
-                      Method::weight_data_fitting,
-                      Method::weight_model_coverage,
-                      Method::weight_model_complexity);
+	// the binary program is formulated only for the first optimization of the candidate faces, and 
+	// then only its objective changes with the weights
+	if (!selection_) {
+		selection_ = new FaceSelection(point_set_, hypothesis_mesh_);
+		if (!selection_->formulate(hypothesis_)) {
+			delete selection_;
+			selection_ = nil;
+		}
+	}
+
+	Map* mesh = nil;
+	if (selection_) {
+		mesh = selection_->select(main_window_->active_solver(),
+								  Method::weight_data_fitting,
+								  Method::weight_model_coverage,
+								  Method::weight_model_complexity);
+	}
+	if (!mesh) {
+		main_window_->actionOptimization->setDisabled(false);
+		hint_text_ = "Optimization failed :-(";
+		hint_text2nd_ = "";
+		update_all();
+		return;
+	}
 
 #if 0 // not stable!!!
     { // to stitch the coincident edges and related vertices
 		const HypothesisGenerator::Adjacency& adjacency = hypothesis_->extract_adjacency(mesh);
         MapEditor editor(mesh);
-        for (auto pair : adjacency) {
+        for (std::size_t i = 0; i < adjacency.size(); ++i) {
+            const HypothesisGenerator::SuperEdge& pair = adjacency[i];
             if (pair.size() != 2) {
                 std::cerr << "error: an edge should be associated with two faces" << std::endl;
                 continue;
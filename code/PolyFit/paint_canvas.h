@@ -29,6 +29,7 @@ class MainWindow;
 class SurfaceRender;
 class PointSetRender;
 class HypothesisGenerator;
+class FaceSelection;
 
 class PaintCanvas : public QGLViewer
 {
@@ -114,6 +115,7 @@ protected:
 	PointSetRender* point_set_render_;
 
 	HypothesisGenerator* hypothesis_;
+	FaceSelection*		 selection_;	// formulated once for the candidate faces, then re-solved for the weights
 
 	bool		show_hint_text_;
 	QString     hint_text_;
@@ -46,24 +46,32 @@ void LinearProgramSolver::upload_solution(const LinearProgram* program) {
 	for (std::size_t i = 0; i < variables.size(); ++i) {
 		Variable* v = variables[i];
 		v->set_solution_value(result_[i]);
-		if (v->variable_type() != Variable::CONTINUOUS)
+		if (v->variable_type() != Variable::CONTINUOUS && !relaxed_)
 			result_[i] = static_cast<int>(std::round(result_[i]));
 	}
 }
 
 
-bool LinearProgramSolver::solve(const LinearProgram* program, SolverName solver) {
+bool LinearProgramSolver::solve(const LinearProgram* program, SolverName solver, const std::vector<double>& hint, bool relaxed) {
+	if (!hint.empty() && hint.size() != program->num_variables()) {
+		std::cerr << "hint ignored: " << hint.size() << " values for " << program->num_variables() << " variables" << std::endl;
+		return solve(program, solver, std::vector<double>(), relaxed);
+	}
+
+	relaxed_ = relaxed;
+	first_solution_time_ = -1;
+
 	switch (solver) {
 #ifdef HAS_GUROBI
 	case GUROBI:
-        return _solve_GUROBI(program);
+        return _solve_GUROBI(program, hint);
 #endif
 //	case GLPK:
 //        return _solve_GLPK(program);
 //	case LPSOLVE:
 //        return _solve_LPSOLVE(program);
 	case SCIP:
-        return _solve_SCIP(program);
+        return _solve_SCIP(program, hint);
 	}
     return false;
 }
@@ -36,14 +36,23 @@ public:
 	};
 
 public:
-	LinearProgramSolver() {}
+	LinearProgramSolver() : objective_value_(0), first_solution_time_(-1), verbose_(true), relaxed_(false) {}
 	~LinearProgramSolver() {}
 
+	// if false, the solver is not reported (e.g., when many small problems are solved concurrently)
+	void set_verbose(bool b) { verbose_ = b; }
+
 	// Solves the problem and returns false if fails.
 	// NOTE: The SCIP and CBC solvers are slower than Gurobi but acceptable. 
 	//       GLPK and LPSOLVE may be too slow or even fail for large problems.
 	//       If you have a really LARGE problem, you may consider using Gurobi.
-    bool solve(const LinearProgram* program, SolverName solver);
+    // A 'hint' (one value per variable, e.g., the solution of the same problem with a slightly
+    // different objective) is passed to the solver as a starting solution. It only helps the 
+    // solver find a good solution early and it doesn't need to be feasible.
+    // If 'relaxed' is true, the linear relaxation of the problem is solved instead, i.e., the integer 
+    // and binary variables are treated as continuous ones within their bounds (e.g., for rounding the 
+    // relaxed solution into a hint).
+    bool solve(const LinearProgram* program, SolverName solver, const std::vector<double>& hint = std::vector<double>(), bool relaxed = false);
 
 	// Returns the result. 
 	// The result can also be retrieved using Variable::solution_value().
@@ -57,21 +66,29 @@ public:
 	//       (2) the constant term is not included.
 	double objective_value() const { return objective_value_; }
 
+	// Returns the time (in seconds from the start of the solving) when the solver found its first feasible
+	// solution, e.g., to measure the effect of a hint (an accepted hint itself is not counted). A negative
+	// value means it is not known (it is only reported by SCIP).
+	double first_solution_time() const { return first_solution_time_; }
+
 private:
 	bool check_program(const LinearProgram* program) const;
 	void upload_solution(const LinearProgram* program);
 
 private:
 #ifdef HAS_GUROBI
-	bool _solve_GUROBI(const LinearProgram* program);
+	bool _solve_GUROBI(const LinearProgram* program, const std::vector<double>& hint);
 #endif
-	bool _solve_SCIP(const LinearProgram* program);
+	bool _solve_SCIP(const LinearProgram* program, const std::vector<double>& hint);
 //	bool _solve_GLPK(const LinearProgram* program);
 //	bool _solve_LPSOLVE(const LinearProgram* program);
 
 private:
 	std::vector<double> result_;
 	double				objective_value_;
+	double				first_solution_time_;
+	bool				verbose_;
+	bool				relaxed_;
 };
 
 #endif
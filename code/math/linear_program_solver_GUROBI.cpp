@@ -24,7 +24,7 @@
 #include <gurobi_c++.h>
 
 
-bool LinearProgramSolver::_solve_GUROBI(const LinearProgram* program) {
+bool LinearProgramSolver::_solve_GUROBI(const LinearProgram* program, const std::vector<double>& hint) {
 	try {
 		if (!check_program(program))
 			return false;
@@ -48,7 +48,13 @@ bool LinearProgramSolver::_solve_GUROBI(const LinearProgram* program) {
 			var->get_bounds(lb, ub);
 
 			char vtype = GRB_CONTINUOUS;
-			if (var->variable_type() == Variable::INTEGER)
+			if (relaxed_) {
+				if (var->variable_type() == Variable::BINARY) {
+					lb = 0.0;
+					ub = 1.0;
+				}
+			}
+			else if (var->variable_type() == Variable::INTEGER)
 				vtype = GRB_INTEGER;
 			else if (var->variable_type() == Variable::BINARY)
 				vtype = GRB_BINARY;
@@ -110,8 +116,13 @@ bool LinearProgramSolver::_solve_GUROBI(const LinearProgram* program) {
 		bool minimize = (objective->sense() == LinearObjective::MINIMIZE);
 		model.setObjective(obj, minimize ? GRB_MINIMIZE : GRB_MAXIMIZE);
 
+		// the hint is the MIP start
+		for (std::size_t i = 0; i < hint.size(); ++i)
+			X[i].set(GRB_DoubleAttr_Start, hint[i]);
+
 		// Optimize model
-        Logger::out("-") << "using the GUROBI solver (version " << GRB_VERSION_MAJOR << "." << GRB_VERSION_MINOR << ")." << std::endl;
+        if (verbose_)
+            Logger::out("-") << "using the GUROBI solver (version " << GRB_VERSION_MAJOR << "." << GRB_VERSION_MINOR << ")." << std::endl;
 		model.optimize();
 
         int status = model.get(GRB_IntAttr_Status);
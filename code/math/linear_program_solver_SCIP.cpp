@@ -23,7 +23,38 @@
 #include <iostream>
 
 
-bool LinearProgramSolver::_solve_SCIP(const LinearProgram* program) {
+// Records the time of the first solution found by SCIP itself. The hint is not counted: it is
+// transferred to the transformed problem when the solving starts (in stage INITSOLVE) as a solution
+// without a heuristic, and it would always report time 0 if it is accepted.
+struct SCIP_EventhdlrData {
+	double first_solution_time;
+};
+
+static SCIP_DECL_EVENTINIT(first_solution_init) {
+	SCIP_CALL(SCIPcatchEvent(scip, SCIP_EVENTTYPE_SOLFOUND, eventhdlr, NULL, NULL));
+	return SCIP_OKAY;
+}
+
+static SCIP_DECL_EVENTEXIT(first_solution_exit) {
+	SCIP_CALL(SCIPdropEvent(scip, SCIP_EVENTTYPE_SOLFOUND, eventhdlr, NULL, -1));
+	return SCIP_OKAY;
+}
+
+static SCIP_DECL_EVENTEXEC(first_solution_exec) {
+	SCIP_EVENTHDLRDATA* data = SCIPeventhdlrGetData(eventhdlr);
+	if (data->first_solution_time >= 0)
+		return SCIP_OKAY;
+
+	SCIP_SOL* sol = SCIPeventGetSol(event);
+	if (SCIPgetStage(scip) == SCIP_STAGE_INITSOLVE && SCIPsolGetHeur(sol) == NULL)
+		return SCIP_OKAY;	// the hint
+
+	data->first_solution_time = SCIPgetSolvingTime(scip);
+	return SCIP_OKAY;
+}
+
+
+bool LinearProgramSolver::_solve_SCIP(const LinearProgram* program, const std::vector<double>& hint) {
 	try {
 		if (!check_program(program))
 			return false;
@@ -55,7 +86,15 @@ bool LinearProgramSolver::_solve_SCIP(const LinearProgram* program) {
 //			SCIP_CALL(SCIPfreeTransform(scip));
 			// The true objective coefficient will be set later in ExtractObjective.
 			double tmp_obj_coef = 0.0;
-			switch (var->variable_type())
+			Variable::VariableType type = var->variable_type();
+			if (relaxed_ && type != Variable::CONTINUOUS) {
+				if (type == Variable::BINARY) {
+					lb = 0.0;
+					ub = 1.0;
+				}
+				type = Variable::CONTINUOUS;
+			}
+			switch (type)
 			{
 			case Variable::CONTINUOUS:
 				SCIP_CALL(SCIPcreateVar(scip, &v, var->name().c_str(), lb, ub, tmp_obj_coef, SCIP_VARTYPE_CONTINUOUS, TRUE, FALSE, 0, 0, 0, 0, 0));
@@ -141,7 +180,24 @@ bool LinearProgramSolver::_solve_SCIP(const LinearProgram* program) {
 		else 
 			SCIP_CALL(SCIPsetIntParam(scip, "presolving/maxrounds", 0));  // disable presolve
 
-		Logger::out("-") << "using the SCIP solver" << std::endl;
+		// the hint is tried as a primal solution when the solving starts
+		if (!hint.empty()) {
+			SCIP_SOL* sol = 0;
+			SCIP_CALL(SCIPcreateSol(scip, &sol, 0));
+			SCIP_CALL(SCIPsetSolVals(scip, sol, static_cast<int>(scip_variables.size()), scip_variables.data(), const_cast<double*>(hint.data())));
+			SCIP_Bool stored = FALSE;
+			SCIP_CALL(SCIPaddSolFree(scip, &sol, &stored));
+		}
+
+		SCIP_EVENTHDLRDATA first_solution = { -1.0 };
+		SCIP_EVENTHDLR* eventhdlr = 0;
+		SCIP_CALL(SCIPincludeEventhdlrBasic(scip, &eventhdlr, "first_solution", "records the time of the first solution found",
+			first_solution_exec, &first_solution));
+		SCIP_CALL(SCIPsetEventhdlrInit(scip, eventhdlr, first_solution_init));
+		SCIP_CALL(SCIPsetEventhdlrExit(scip, eventhdlr, first_solution_exit));
+
+		if (verbose_)
+			Logger::out("-") << "using the SCIP solver" << std::endl;
 
 		bool status = false;
 		// this tells scip to start the solution process
@@ -158,6 +214,8 @@ bool LinearProgramSolver::_solve_SCIP(const LinearProgram* program) {
 				status = true;
 				upload_solution(program);
 			}
+
+			first_solution_time_ = first_solution.first_solution_time;
 		}
 
 		// report the status: optimal, infeasible, etc.
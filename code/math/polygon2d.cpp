@@ -254,6 +254,22 @@ namespace Geom {
 		return vec2(x,y) ;
 	}
 
+	bool polygon_is_convex(const Polygon2d& P) {
+		Sign s = ZERO ;
+		for(unsigned int i=0; i<P.size(); i++) {
+			unsigned int j = ((i+1) % P.size()) ;
+			unsigned int k = ((j+1) % P.size()) ;
+			Sign cur_s = ogf_sgn(det(P[j]-P[i],P[k]-P[j])) ;
+			if(s != ZERO && cur_s != ZERO && cur_s != s) {
+				return false ;
+			}
+			if(cur_s != ZERO) {
+				s = cur_s ;
+			}
+		}
+		return true ;
+	}
+
 	static inline Sign opposite(Sign sign_in) {
 		return Sign(-int(sign_in)) ;
 	}
@@ -288,6 +304,62 @@ namespace Geom {
 			return true ;
 	}
 
+	static inline Sign orient(const vec2& p1, const vec2& p2, const vec2& p3) {
+		return ogf_sgn(det(p2 - p1, p3 - p1)) ;
+	}
+
+	static void clip_polygon_by_half_plane(
+		const Polygon2d& P, 
+		const vec2& q1,
+		const vec2& q2,
+		Polygon2d& result
+		) {
+			result.clear() ;
+			if(P.size() == 0) {
+				return ;
+			}
+
+			if(P.size() == 1) {
+				if(orient(q1, q2, P[0]) > 0) {
+					result.push_back(P[0]) ;
+				}
+				return ;
+			}
+
+			vec2 prev_p = P[P.size() - 1] ;
+			Sign prev_status = orient(q1, q2, prev_p) ;
+			for(unsigned int i=0; i<P.size(); i++) {
+				const vec2& p = P[i] ;
+				Sign status = orient(q1, q2, p) ;
+				if(status != prev_status && status != ZERO && prev_status != ZERO) {
+					vec2 intersect ;
+					if(intersect_segments(prev_p, p, q1, q2, intersect)) {
+						result.push_back(intersect) ;
+					} 
+				}
+				if(status != NEGATIVE) {
+					result.push_back(p) ;
+				}
+				prev_p = p ;
+				prev_status = status ;
+			}
+	}
+
+	void convex_clip_polygon(
+		const Polygon2d& P, const Polygon2d& clip, Polygon2d& result
+		) {
+			Polygon2d tmp1 = P ;
+			Polygon2d tmp2 ;
+			Polygon2d* src = &tmp1 ;
+			Polygon2d* dst = &tmp2 ;
+			for(unsigned int i=0; i<clip.size(); i++) {
+				unsigned int j = ((i+1) % clip.size()) ;
+				clip_polygon_by_half_plane(*src, clip[i], clip[j], *dst) ;
+				ogf_swap(src, dst) ;
+			}
+			result = *src ;
+	}
+
 	void save_polygon(const Polygon2d& P, const std::string& file_name) {
 		std::ofstream out(file_name.c_str()) ;
 		{for(unsigned int i=0; i<P.size(); i++) {
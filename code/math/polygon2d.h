@@ -78,6 +78,16 @@ namespace Geom {
 
 	bool MATH_API polygon_is_convex(const Polygon2d& P) ;
 
+	/**
+	* Sutherland-Hodgman clipping of P by a convex polygon.
+	* Note: clip must be convex and counterclockwise, P can
+	* be non-convex (then the result may have degenerate 
+	* edges, but its area is still correct).
+	*/
+	void MATH_API convex_clip_polygon(
+		const Polygon2d& P, const Polygon2d& clip, Polygon2d& result
+		) ;
+
 }
 
 
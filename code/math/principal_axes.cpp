@@ -130,6 +130,59 @@ void PrincipalAxes3d::add_point(const vec3& p, double weight) {
 	sum_weights_ += weight ;
 }
 
+void PrincipalAxes3d::compute(const PointMoments3d& moments) {
+	nb_points_ = moments.nb_points_ ;
+	sum_weights_ = moments.nb_points_ ;
+	for(int i=0; i<3; i++) {
+		center_[i] = moments.sum_[i] ;
+	}
+	for(int i=0; i<6; i++) {
+		M_[i] = moments.M_[i] ;
+	}
+	end() ;
+}
+
+//_________________________________________________________
+
+PointMoments3d::PointMoments3d() {
+	clear() ;
+}
+
+void PointMoments3d::clear() {
+	nb_points_ = 0 ;
+	sum_[0] = sum_[1] = sum_[2] = 0 ;
+	M_[0] = M_[1] = M_[2] = M_[3] = M_[4] = M_[5] = 0 ;
+}
+
+void PointMoments3d::add_point(const vec3& p) {
+	double x = p.x ;
+	double y = p.y ; 
+	double z = p.z ;
+
+	sum_[0] += x ;
+	sum_[1] += y ;
+	sum_[2] += z ;
+
+	M_[0] += x*x ;
+	M_[1] += x*y ;
+	M_[2] += y*y ;
+	M_[3] += x*z ;
+	M_[4] += y*z ;
+	M_[5] += z*z ;
+
+	nb_points_++ ;
+}
+
+void PointMoments3d::add(const PointMoments3d& rhs) {
+	for(int i=0; i<3; i++) {
+		sum_[i] += rhs.sum_[i] ;
+	}
+	for(int i=0; i<6; i++) {
+		M_[i] += rhs.M_[i] ;
+	}
+	nb_points_ += rhs.nb_points_ ;
+}
+
 //_________________________________________________________
 
 PrincipalAxes2d::PrincipalAxes2d() {
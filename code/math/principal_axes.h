@@ -46,6 +46,33 @@
 // eigen values are sorted in descending order, 
 // eigen vectors are sorted in accordance.
 
+
+/**
+* PointMoments3d accumulates the first- and second-order moments 
+* (i.e., the sums of the coordinates and of their products) of a
+* cloud of 3d points. The moments of two clouds can be merged in
+* constant time, and the principal axes can be computed from them
+* without visiting the points again (see PrincipalAxes3d::compute()).
+*/
+class MATH_API PointMoments3d {
+public:
+	PointMoments3d() ;
+	void clear() ;
+	void add_point(const vec3& p) ;
+	void add(const PointMoments3d& rhs) ;
+
+	int nb_points() const { return nb_points_ ; }
+
+private:
+	double	sum_[3] ;
+	double	M_[6] ;
+	int		nb_points_ ;
+
+	friend class PrincipalAxes3d ;
+} ;
+
+//_________________________________________________________
+
 /**
 * PrincipalAxes3d enables the center and inertia axes of
 * a cloud of 3d points to be computed.
@@ -57,6 +84,9 @@ public:
 	void add_point(const vec3& p, double weight = 1.0) ;
 	void end() ;
 
+	// equivalent to begin(), add_point() for all the points, and end()
+	void compute(const PointMoments3d& moments) ;
+
 	vec3 center() const ;
 	const vec3& axis(int i) const ;
 	double eigen_value(int i) const ; 
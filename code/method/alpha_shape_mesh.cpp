@@ -22,6 +22,22 @@
 #include <model/map.h>
 #include <model/map_builder.h>
 #include <method/alpha_shape.h>
+#include <method/polygon_grid_2d.h>
+#include <math/polygon2d.h>
+
+
+namespace {
+
+	// the area of a (finite) face of the alpha shape, computed in the 2D coordinate system of the plane
+	inline double face_area(const AlphaShape::Finite_faces_iterator& fit) {
+		const Point2& a = fit->vertex(0)->point();
+		const Point2& b = fit->vertex(1)->point();
+		const Point2& c = fit->vertex(2)->point();
+		double cross = (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+		return std::fabs(cross) * 0.5;
+	}
+
+}
 
 
 // return the indices of boundary points
@@ -130,3 +146,71 @@ Map* AlphaShapeMesh::apply(const PointSet* pset, const std::vector<unsigned int>
 	AlphaShape as(pts.begin(), pts.end());
 	return apply(&as, plane, radius);
 }
+
+
+void AlphaShapeMesh::covered_areas(
+	const PointSet* pset,
+	const std::vector<unsigned int>& point_indices,
+	const Plane3d& plane,
+	float radius,
+	const std::vector<Polygon2d>& regions,
+	std::vector<double>& areas)
+{
+	areas.assign(regions.size(), 0.0);
+	if (point_indices.size() < 10 || regions.empty())
+		return;
+
+	const std::vector<vec3>& points = pset->points();
+
+	std::list<Point2> pts;
+	for (std::size_t i = 0; i < point_indices.size(); ++i) {
+		unsigned int idx = point_indices[i];
+		const vec3& p = points[idx];
+		const vec2& q = plane.to_2d(p);
+		pts.push_back(to_cgal_point(q));
+	}
+
+	AlphaShape as(pts.begin(), pts.end());
+	as.set_alpha(radius * radius);
+
+	PolygonGrid2d grid(regions);
+	std::vector<bool> convex(regions.size());
+	for (std::size_t i = 0; i < regions.size(); ++i)
+		convex[i] = regions[i].size() >= 3 && Geom::polygon_is_convex(regions[i]);
+
+	std::vector<int> candidates;
+	Polygon2d triangle, clipped;
+	triangle.resize(3);
+	for (AlphaShape::Finite_faces_iterator fit = as.finite_faces_begin(); fit != as.finite_faces_end(); ++fit) {
+		if (as.classify(fit) != AlphaShape::INTERIOR)
+			continue;
+
+		for (int i = 0; i < 3; ++i)
+			triangle[i] = to_my_point(fit->vertex(i)->point());
+		if (Geom::signed_area(triangle) < 0)	// the clipping polygon must be counterclockwise
+			std::swap(triangle[1], triangle[2]);
+
+		float xmin = std::min(triangle[0].x, std::min(triangle[1].x, triangle[2].x));
+		float xmax = std::max(triangle[0].x, std::max(triangle[1].x, triangle[2].x));
+		float ymin = std::min(triangle[0].y, std::min(triangle[1].y, triangle[2].y));
+		float ymax = std::max(triangle[0].y, std::max(triangle[1].y, triangle[2].y));
+		grid.overlapping(xmin, ymin, xmax, ymax, candidates);
+
+		// the triangle is always convex, so the regions (which may be non-convex) are clipped by it
+		for (std::size_t i = 0; i < candidates.size(); ++i) {
+			int id = candidates[i];
+			const Polygon2d& region = regions[id];
+			if (convex[id] &&
+				Geom::point_is_in_polygon(region, triangle[0]) &&
+				Geom::point_is_in_polygon(region, triangle[1]) &&
+				Geom::point_is_in_polygon(region, triangle[2]))
+			{	// most triangles are completely inside a region, and no clipping is needed
+				areas[id] += face_area(fit);
+				continue;
+			}
+			Geom::convex_clip_polygon(region, triangle, clipped);
+			if (clipped.size() >= 3)
+				areas[id] += Geom::area(clipped);
+		}
+	}
+}
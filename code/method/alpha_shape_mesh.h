@@ -39,4 +39,17 @@ public:
 	// the input is a subset of a point cloud and the points lie on plane
 	static Map* apply(const PointSet* pset, const std::vector<unsigned int>& point_indices, const Plane3d& plane, float radius);
 
+	// computes the areas of the 2D regions (in the coordinate system of 'plane') that are covered by 
+	// the alpha shape of the points. Only one alpha shape is built for all the regions, whose interior 
+	// triangles are clipped against the regions overlapping them. Compared to an alpha shape for each 
+	// region, this is much cheaper if there are many regions (e.g., the candidate faces on a plane).
+	static void covered_areas(
+		const PointSet* pset, 
+		const std::vector<unsigned int>& point_indices, 
+		const Plane3d& plane, 
+		float radius,
+		const std::vector<Polygon2d>& regions,
+		std::vector<double>& areas
+	);
+
 };
\ No newline at end of file
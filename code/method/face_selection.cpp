@@ -26,54 +26,249 @@
 
 #include <algorithm>
 #include <limits>
+#include <thread>
+#include <atomic>
 
 
 FaceSelection::FaceSelection(PointSet* pset, Map* model)
 	: pset_(pset)
 	, model_(model)
+	, num_threads_(1)
+	, initial_solution_(NONE)
+	, num_initial_solutions_(0)
+	, num_empty_initial_solutions_(0)
+	, generator_(nullptr)
 {
 }
 
 
-void FaceSelection::optimize(HypothesisGenerator* generator,
-                             LinearProgramSolver::SolverName solver_name,
-                             double data_fitting,
-                             double model_coverage,
-                             double model_complexity)
- {
-    if (pset_ == nullptr || model_ == nullptr)
-		return;
-
+bool FaceSelection::bind_attributes() {
 	facet_attrib_supporting_vertex_group_.bind_if_defined(model_, Method::facet_attrib_supporting_vertex_group);
 	if (!facet_attrib_supporting_vertex_group_.is_bound()) {
 		Logger::err("-") << "attribute " << Method::facet_attrib_supporting_vertex_group << " doesn't exist" << std::endl;
-		return;
+		return false;
 	}
 	facet_attrib_supporting_point_num_.bind_if_defined(model_, Method::facet_attrib_supporting_point_num);
 	if (!facet_attrib_supporting_point_num_.is_bound()) {
 		Logger::err("-") << "attribute " << Method::facet_attrib_supporting_point_num << " doesn't exist" << std::endl;
-		return;
+		return false;
 	}
 	facet_attrib_facet_area_.bind_if_defined(model_, Method::facet_attrib_facet_area);
 	if (!facet_attrib_facet_area_.is_bound()) {
 		Logger::err("-") << "attribute " << Method::facet_attrib_facet_area << " doesn't exist" << std::endl;
-		return;
+		return false;
 	}
 	facet_attrib_covered_area_.bind_if_defined(model_, Method::facet_attrib_covered_area);
 	if (!facet_attrib_covered_area_.is_bound()) {
 		Logger::err("-") << "attribute " << Method::facet_attrib_covered_area << " doesn't exist" << std::endl;
-		return;
+		return false;
 	}
 
-    auto adjacency = generator->extract_adjacency(model_);
-
 	edge_source_planes_.bind_if_defined(model_, "EdgeSourcePlanes");
 	vertex_source_planes_.bind_if_defined(model_, "VertexSourcePlanes");
 	facet_attrib_supporting_plane_.bind_if_defined(model_, "FacetSupportingPlane");
+	return true;
+}
 
-	//////////////////////////////////////////////////////////////////////////
 
-	double total_points = double(pset_->points().size());
+void FaceSelection::unbind_attributes() {
+	if (facet_attrib_supporting_vertex_group_.is_bound())
+		facet_attrib_supporting_vertex_group_.unbind();
+	if (facet_attrib_supporting_point_num_.is_bound())
+		facet_attrib_supporting_point_num_.unbind();
+	if (facet_attrib_facet_area_.is_bound())
+		facet_attrib_facet_area_.unbind();
+	if (facet_attrib_covered_area_.is_bound())
+		facet_attrib_covered_area_.unbind();
+
+	if (vertex_source_planes_.is_bound())
+		vertex_source_planes_.unbind();
+	if (edge_source_planes_.is_bound())
+		edge_source_planes_.unbind();
+	if (facet_attrib_supporting_plane_.is_bound())
+		facet_attrib_supporting_plane_.unbind();
+}
+
+
+namespace {
+
+	// The faces of the super edges and the super edges of the faces, both in a flat layout: the faces of
+	// super edge i are faces[j] for adjacency.offsets()[i] <= j < adjacency.offsets()[i + 1] (a face 
+	// appears once per halfedge), and the super edges of face f are fans[j] for offsets[f] <= j < offsets[f + 1].
+	struct FanIncidence {
+		std::vector<std::size_t> faces;
+		std::vector<std::size_t> offsets;
+		std::vector<std::size_t> fans;
+	};
+
+	void build_fan_incidence(
+		const HypothesisGenerator::Adjacency& adjacency,
+		const MapFacetAttribute<std::size_t>& facet_indices,
+		std::size_t num_faces,
+		FanIncidence& incidence
+	)
+	{
+		std::vector<std::size_t>& fan_faces = incidence.faces;
+		std::vector<std::size_t>& offsets = incidence.offsets;
+		fan_faces.resize(adjacency.halfedges().size());
+		offsets.assign(num_faces + 1, 0);
+		for (std::size_t i = 0; i < adjacency.size(); ++i) {
+			const HypothesisGenerator::SuperEdge& fan = adjacency[i];
+			for (std::size_t j = 0; j < fan.size(); ++j) {
+				std::size_t fid = facet_indices[fan[j]->facet()];
+				fan_faces[adjacency.offsets()[i] + j] = fid;
+				++offsets[fid + 1];
+			}
+		}
+		for (std::size_t i = 0; i < num_faces; ++i)
+			offsets[i + 1] += offsets[i];
+
+		incidence.fans.resize(offsets.back());
+		std::vector<std::size_t> pos(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < adjacency.size(); ++i) {
+			for (std::size_t j = adjacency.offsets()[i]; j < adjacency.offsets()[i + 1]; ++j)
+				incidence.fans[pos[fan_faces[j]]++] = i;
+		}
+	}
+
+
+	// Presolve: the faces that can't be selected. A face having an edge that is not usable (e.g., a 
+	// border edge, with no other face to pair with) is never selected, and then an edge left with a 
+	// single face that can still be selected can't be used by it either ('x = 2 * e' only allows x = 0), 
+	// and so on. 'excluded' returns the faces fixed to be not selected, and the function returns their
+	// number.
+	std::size_t exclude_unpaired_faces(
+		const HypothesisGenerator::Adjacency& adjacency,
+		const MapFacetAttribute<std::size_t>& facet_indices,
+		std::size_t num_faces,
+		std::vector<char>& excluded
+	)
+	{
+		FanIncidence incidence;
+		build_fan_incidence(adjacency, facet_indices, num_faces, incidence);
+		const std::vector<std::size_t>& fan_faces = incidence.faces;
+		const std::vector<std::size_t>& offsets = incidence.offsets;
+		const std::vector<std::size_t>& face_fans = incidence.fans;
+
+		excluded.assign(num_faces, 0);
+		std::vector<std::size_t> num_free(adjacency.size());	// the faces of each edge not excluded yet
+		std::vector<std::size_t> queue;
+		for (std::size_t i = 0; i < adjacency.size(); ++i) {
+			num_free[i] = adjacency[i].size();
+			if (adjacency.usable(i))
+				continue;
+			for (std::size_t e = adjacency.offsets()[i]; e < adjacency.offsets()[i + 1]; ++e) {
+				std::size_t g = fan_faces[e];
+				if (!excluded[g]) {
+					excluded[g] = 1;
+					queue.push_back(g);
+				}
+			}
+		}
+
+		for (std::size_t k = 0; k < queue.size(); ++k) {
+			std::size_t f = queue[k];
+			for (std::size_t j = offsets[f]; j < offsets[f + 1]; ++j) {
+				std::size_t i = face_fans[j];
+				if (--num_free[i] != 1)
+					continue;
+				for (std::size_t e = adjacency.offsets()[i]; e < adjacency.offsets()[i + 1]; ++e) {
+					std::size_t g = fan_faces[e];
+					if (!excluded[g]) {
+						excluded[g] = 1;
+						queue.push_back(g);
+					}
+				}
+			}
+		}
+		return queue.size();
+	}
+
+
+	// Repairs the 'selected' faces into a closed surface (i.e., each edge has either 0 or 2 selected 
+	// faces). At an edge with a single selected face, the unselected face with the highest score is 
+	// added if the average score of the pair is above 'threshold' (the score at which a face is 
+	// selected), otherwise the selected face is removed. At an edge with more than two selected faces,
+	// the one with the lowest score is removed. The 'excluded' faces are never added, and a face is 
+	// added at most once, so the repair terminates. 'added' and 'removed' return the number of changes.
+	void close_surface(
+		const HypothesisGenerator::Adjacency& adjacency,
+		const FanIncidence& incidence,
+		const std::vector<double>& scores,
+		double threshold,
+		const std::vector<char>& excluded,
+		std::vector<char>& selected,
+		std::size_t& added,
+		std::size_t& removed
+	)
+	{
+		const std::size_t none = std::numeric_limits<std::size_t>::max();
+		std::vector<std::size_t> count(adjacency.size(), 0);	// the selected faces of each edge
+		std::vector<std::size_t> stack;
+		std::vector<char> queued(adjacency.size(), 0);
+		for (std::size_t i = 0; i < adjacency.size(); ++i) {
+			for (std::size_t j = adjacency.offsets()[i]; j < adjacency.offsets()[i + 1]; ++j) {
+				if (selected[incidence.faces[j]])
+					++count[i];
+			}
+			if (count[i] != 0 && count[i] != 2) {
+				stack.push_back(i);
+				queued[i] = 1;
+			}
+		}
+
+		std::vector<char> tried(selected.size(), 0);	// the faces that have been added
+		added = removed = 0;
+		while (!stack.empty()) {
+			std::size_t i = stack.back();
+			stack.pop_back();
+			queued[i] = 0;
+			if (count[i] == 0 || count[i] == 2)
+				continue;
+
+			std::size_t worst = none, best = none;
+			for (std::size_t j = adjacency.offsets()[i]; j < adjacency.offsets()[i + 1]; ++j) {
+				std::size_t f = incidence.faces[j];
+				if (selected[f]) {
+					if (worst == none || scores[f] < scores[worst])
+						worst = f;
+				}
+				else if (!excluded[f] && !tried[f] && (best == none || scores[f] > scores[best]))
+					best = f;
+			}
+
+			std::size_t changed = worst;
+			if (count[i] == 1 && best != none && (scores[worst] + scores[best]) * 0.5 > threshold) {
+				changed = best;
+				selected[best] = 1;
+				tried[best] = 1;
+				++added;
+			}
+			else {
+				selected[worst] = 0;
+				++removed;
+			}
+
+			for (std::size_t j = incidence.offsets[changed]; j < incidence.offsets[changed + 1]; ++j) {
+				std::size_t e = incidence.fans[j];
+				if (selected[changed])
+					++count[e];
+				else
+					--count[e];
+				if (!queued[e] && count[e] != 0 && count[e] != 2) {
+					stack.push_back(e);
+					queued[e] = 1;
+				}
+			}
+		}
+	}
+
+}
+
+
+void FaceSelection::formulate_constraints() {
+	const HypothesisGenerator::Adjacency& adjacency = adjacency_;
+
 	std::size_t idx = 0;
 	MapFacetAttribute<std::size_t>	facet_indices(model_);
 	FOR_EACH_FACET(Map, model_, it) {
@@ -82,72 +277,49 @@ void FaceSelection::optimize(HypothesisGenerator* generator,
 		++idx;
 	}
 
-	//-------------------------------------
-
-	StopWatch w;
-    Logger::out("-") << "face selection..." << std::endl;
-
-	//-------------------------------------
-
 	// binary variables:
 	// x[0] ... x[num_faces - 1] : binary labels of all the input faces
 	// x[num_faces] ... x[num_faces + num_edges] : binary labels of all the intersecting edges (remain or not)
 	// x[num_faces + num_edges] ... x[num_faces + num_edges + num_edges] : binary labels of corner edges (sharp edge of not)
-
-	Logger::out("-") << "formulating binary program...." << std::endl;
-	w.start();
+	// The variables fixed by the presolve are not in the program, and reduced_index_ maps the above 
+	// indices to the ones of the program.
 
 	std::size_t num_faces = model_->size_of_facets();
 	std::size_t num_edges = 0;
 
+	// only the usable edges have variables (see HypothesisGenerator::Adjacency::usable()), and the faces
+	// of the other edges are not selected
 	typedef typename HypothesisGenerator::SuperEdge SuperEdge;
-	std::map<const SuperEdge*, std::size_t> edge_usage_status;	// keep or remove an intersecting edges
+	edge_usage_status_.assign(adjacency.size(), 0);	// keep or remove an intersecting edges
 	for (std::size_t i = 0; i < adjacency.size(); ++i) {
-		const SuperEdge& fan = adjacency[i];
-		if (fan.size() == 4) {
+		if (adjacency.usable(i)) {
 			std::size_t var_idx = num_faces + num_edges;
-			edge_usage_status[&fan] = var_idx;
+			edge_usage_status_[i] = var_idx;
 			++num_edges;
 		}
 	}
 
-	//double coeff_data_fitting = data_fitting / total_points;
-	//double coeff_coverage = model_coverage / model_->bbox().area();
-	//double coeff_complexity = model_complexity / double(fans.size());
-	// choose a better scale
-	double coeff_data_fitting = data_fitting;
-	double coeff_coverage = total_points * model_coverage / model_->bbox().area();
-	double coeff_complexity = total_points * model_complexity / double(adjacency.size());
-
-	program_.clear();
-	LinearObjective* objective = program_.create_objective(LinearObjective::MINIMIZE);
-
-	std::map<const SuperEdge*, std::size_t> edge_sharp_status;	// the edge is sharp or not
+	edge_sharp_status_.assign(adjacency.size(), 0);	// the edge is sharp or not
 	std::size_t num_sharp_edges = 0;
 	for (std::size_t i = 0; i < adjacency.size(); ++i) {
-		const SuperEdge& fan = adjacency[i];
-		if (fan.size() == 4) {
+		if (adjacency.usable(i)) {
 			std::size_t var_idx = num_faces + num_edges + num_sharp_edges;
-			edge_sharp_status[&fan] = var_idx;
-
-			// accumulate model complexity term
-			objective->add_coefficient(var_idx, coeff_complexity);
+			edge_sharp_status_[i] = var_idx;
 			++num_sharp_edges;
 		}
 	}
 	assert(num_edges == num_sharp_edges);
 
+	// the quality measures of the faces (in the order of the variables) for the objective, and their 
+	// planes for the initial solution
+	supporting_point_num_.clear();
+	uncovered_area_.clear();
+	supporting_planes_.clear();
 	FOR_EACH_FACET(Map, model_, it) {
 		Map::Facet* f = it;
-		std::size_t var_idx = facet_indices[f];
-
-		// accumulate data fitting term
-		double num = facet_attrib_supporting_point_num_[f];
-		objective->add_coefficient(var_idx, -coeff_data_fitting * num);
-
-		// accumulate model coverage term
-		double uncovered_area = (facet_attrib_facet_area_[f] - facet_attrib_covered_area_[f]);
-		objective->add_coefficient(var_idx, coeff_coverage * uncovered_area);
+		supporting_point_num_.push_back(facet_attrib_supporting_point_num_[f]);
+		uncovered_area_.push_back(facet_attrib_facet_area_[f] - facet_attrib_covered_area_[f]);
+		supporting_planes_.push_back(facet_attrib_supporting_plane_[f]);
 	}
 
 	std::size_t total_variables = num_faces + num_edges + num_sharp_edges;
@@ -156,16 +328,50 @@ void FaceSelection::optimize(HypothesisGenerator* generator,
 	Logger::out(" ") << "    - edge is used: " << num_edges << std::endl;
 	Logger::out(" ") << "    - edge is sharp: " << num_sharp_edges << std::endl;
 
+	//////////////////////////////////////////////////////////////////////////
+
+	// Presolve: the faces that can't be selected are removed from the program, together with the edges 
+	// that are left without any face (they are neither used nor sharp) and the constraints that become
+	// trivial. All the removed variables are 0.
+	std::vector<char> excluded;
+	std::size_t num_excluded = exclude_unpaired_faces(adjacency, facet_indices, num_faces, excluded);
+
+	std::vector<std::size_t> num_free(adjacency.size(), 0);	// the faces of each edge that can be selected
+	for (std::size_t i = 0; i < adjacency.size(); ++i) {
+		const SuperEdge& fan = adjacency[i];
+		for (std::size_t j = 0; j < fan.size(); ++j) {
+			if (!excluded[facet_indices[fan[j]->facet()]])
+				++num_free[i];
+		}
+	}
+
+	reduced_index_.assign(total_variables, -1);
+	int num_reduced = 0;
+	for (std::size_t i = 0; i < num_faces; ++i) {
+		if (!excluded[i])
+			reduced_index_[i] = num_reduced++;
+	}
+	for (std::size_t i = 0; i < adjacency.size(); ++i) {
+		if (adjacency.usable(i) && num_free[i] > 0)
+			reduced_index_[edge_usage_status_[i]] = num_reduced++;
+	}
+	for (std::size_t i = 0; i < adjacency.size(); ++i) {
+		if (adjacency.usable(i) && num_free[i] > 0)
+			reduced_index_[edge_sharp_status_[i]] = num_reduced++;
+	}
+
+	program_.clear();
+
 #if 1
-	const std::vector<Variable*>& variables = program_.create_n_variables(total_variables);
-	for (std::size_t i = 0; i < total_variables; ++i) {
+	const std::vector<Variable*>& variables = program_.create_n_variables(num_reduced);
+	for (int i = 0; i < num_reduced; ++i) {
 		Variable* v = variables[i];
 		v->set_variable_type(Variable::BINARY);
 	}
 #else // Liangliang: I was just curious about how the results look like if all variables 
 	//             are relaxed to be continuous.
-	const std::vector<Variable*>& variables = program_.create_n_variables(total_variables);
-	for (std::size_t i = 0; i < total_variables; ++i) {
+	const std::vector<Variable*>& variables = program_.create_n_variables(num_reduced);
+	for (int i = 0; i < num_reduced; ++i) {
 		Variable* v = variables[i];
 		v->set_variable_type(Variable::CONTINUOUS);
 		v->set_bounds(Variable::DOUBLE, 0, 1);
@@ -174,25 +380,25 @@ void FaceSelection::optimize(HypothesisGenerator* generator,
 
 	//////////////////////////////////////////////////////////////////////////
 
+	std::size_t num_constraints = 0;	// including the ones removed by the presolve
+
 	// Add constraints: the number of faces associated with an edge must be either 2 or 0
-	std::size_t var_edge_used_idx = 0;
 	for (std::size_t i = 0; i < adjacency.size(); ++i) {
+		++num_constraints;
+		if (num_free[i] == 0) // an edge that is not usable, or none of its faces can be selected
+			continue;
+
 		LinearConstraint* c = program_.create_constraint(LinearConstraint::FIXED, 0.0, 0.0);
 		const SuperEdge& fan = adjacency[i];
 		for (std::size_t j = 0; j < fan.size(); ++j) {
 			MapTypes::Facet* f = fan[j]->facet();
 			std::size_t var_idx = facet_indices[f];
-			c->add_coefficient(var_idx, 1.0);
+			if (!excluded[var_idx])
+				c->add_coefficient(reduced_index_[var_idx], 1.0);
 		}
 
-		if (fan.size() == 4) {
-			std::size_t var_idx = num_faces + var_edge_used_idx;
-			c->add_coefficient(var_idx, -2.0);  // 
-			++var_edge_used_idx;
-		}
-		else { // boundary edge
-		    // will be set to 0 (i.e., we don't allow open surface)
-		}
+		std::size_t var_idx = edge_usage_status_[i];
+		c->add_coefficient(reduced_index_[var_idx], -2.0);  // 
 	}
 
 	// Add constraints: for the sharp edges. The explanation of posing this constraint can be found here:
@@ -200,17 +406,21 @@ void FaceSelection::optimize(HypothesisGenerator* generator,
 	double M = 1.0;
 	for (std::size_t i = 0; i < adjacency.size(); ++i) {
 		const SuperEdge& fan = adjacency[i];
-		if (fan.size() != 4)
+		if (!adjacency.usable(i))
 			continue;
 
 		// if an edge is sharp, the edge must be selected first:
 		// X[var_edge_usage_idx] >= X[var_edge_sharp_idx]	
-		LinearConstraint* c = program_.create_constraint();
-		std::size_t var_edge_usage_idx = edge_usage_status[&fan];
-		c->add_coefficient(var_edge_usage_idx, 1.0);
-		std::size_t var_edge_sharp_idx = edge_sharp_status[&fan];
-		c->add_coefficient(var_edge_sharp_idx, -1.0);
-		c->set_bound(LinearConstraint::LOWER, 0.0);
+		++num_constraints;
+		bool removed = (num_free[i] == 0);
+		int var_edge_usage_idx = reduced_index_[edge_usage_status_[i]];
+		int var_edge_sharp_idx = reduced_index_[edge_sharp_status_[i]];
+		if (!removed) {
+			LinearConstraint* c = program_.create_constraint();
+			c->add_coefficient(var_edge_usage_idx, 1.0);
+			c->add_coefficient(var_edge_sharp_idx, -1.0);
+			c->set_bound(LinearConstraint::LOWER, 0.0);
+		}
 
 		for (std::size_t j = 0; j < fan.size(); ++j) {
 			MapTypes::Facet* f1 = fan[j]->facet();
@@ -222,14 +432,19 @@ void FaceSelection::optimize(HypothesisGenerator* generator,
 				std::size_t fid2 = facet_indices[f2];
 
 				if (plane1 != plane2) {
+					++num_constraints;
+					// with one of the faces fixed to 0, the constraint always holds (for M >= 1)
+					if (removed || excluded[fid1] || excluded[fid2])
+						continue;
+
 					// the constraint is:
 					//X[var_edge_sharp_idx] + M * (3 - (X[fid1] + X[fid2] + X[var_edge_usage_idx])) >= 1
 					// which equals to  
 					//X[var_edge_sharp_idx] - M * X[fid1] - M * X[fid2] - M * X[var_edge_usage_idx] >= 1 - 3M
-					c = program_.create_constraint();
+					LinearConstraint* c = program_.create_constraint();
 					c->add_coefficient(var_edge_sharp_idx, 1.0);
-					c->add_coefficient(fid1, -M);
-					c->add_coefficient(fid2, -M);
+					c->add_coefficient(reduced_index_[fid1], -M);
+					c->add_coefficient(reduced_index_[fid2], -M);
 					c->add_coefficient(var_edge_usage_idx, -M);
 					c->set_bound(LinearConstraint::LOWER, 1.0 - 3.0 * M);
 				}
@@ -238,19 +453,468 @@ void FaceSelection::optimize(HypothesisGenerator* generator,
 	}
 
 #if 1
-    // Add some optional constraints: border faces must be removed
+    // Add some optional constraints: border faces must be removed. They are all removed by the presolve.
     for (std::size_t i = 0; i < adjacency.size(); ++i) {
         const SuperEdge &fan = adjacency[i];
-        if (fan.size() == 1) { // boundary edge
-            MapTypes::Facet* f = fan[0]->facet();
-            std::size_t var_idx = facet_indices[f];
-            LinearConstraint* c = program_.create_constraint(LinearConstraint::FIXED, 0.0, 0.0);
-            c->add_coefficient(var_idx, 1.0);
-        }
+        if (fan.size() == 1) // boundary edge
+            ++num_constraints;
     }
 #endif
 
+	Logger::out("-") << "presolve: " << total_variables - num_reduced << " variables (" << num_excluded << " faces) and "
+		<< num_constraints - program_.constraints().size() << " constraints eliminated" << std::endl;
 	Logger::out("-") << "#total constraints: " << program_.constraints().size() << std::endl;
+}
+
+
+void FaceSelection::formulate_objective(double data_fitting, double model_coverage, double model_complexity) {
+	double total_points = double(pset_->points().size());
+
+	//double coeff_data_fitting = data_fitting / total_points;
+	//double coeff_coverage = model_coverage / model_->bbox().area();
+	//double coeff_complexity = model_complexity / double(fans.size());
+	// choose a better scale
+	double coeff_data_fitting = data_fitting;
+	double coeff_coverage = total_points * model_coverage / model_->bbox().area();
+	double coeff_complexity = total_points * model_complexity / double(adjacency_.size());
+
+	// the variables removed by the presolve are 0, so they don't contribute to the objective
+	LinearObjective* objective = program_.create_objective(LinearObjective::MINIMIZE);
+
+	for (std::size_t i = 0; i < adjacency_.size(); ++i) {
+		if (adjacency_.usable(i) && reduced_index_[edge_sharp_status_[i]] >= 0) {
+			// accumulate model complexity term
+			objective->add_coefficient(reduced_index_[edge_sharp_status_[i]], coeff_complexity);
+		}
+	}
+
+	for (std::size_t var_idx = 0; var_idx < supporting_point_num_.size(); ++var_idx) {
+		int idx = reduced_index_[var_idx];
+		if (idx < 0)
+			continue;
+
+		// accumulate data fitting term
+		objective->add_coefficient(idx, -coeff_data_fitting * supporting_point_num_[var_idx]);
+
+		// accumulate model coverage term
+		objective->add_coefficient(idx, coeff_coverage * uncovered_area_[var_idx]);
+	}
+}
+
+
+namespace {
+
+	std::size_t find_root(std::vector<std::size_t>& parent, std::size_t i) {
+		while (parent[i] != i) {
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+
+
+	// Splits the variables of 'program' into the groups not linked by any constraint. 'groups' returns 
+	// the variables of each group (ordered by their first variable), and 'constraint_group' the group
+	// of each constraint (-1 for a constraint without variables).
+	void split_program(const LinearProgram& program, std::vector< std::vector<int> >& groups, std::vector<int>& constraint_group) {
+		std::size_t num_variables = program.num_variables();
+		std::vector<std::size_t> parent(num_variables);
+		for (std::size_t i = 0; i < num_variables; ++i)
+			parent[i] = i;
+
+		const std::vector<LinearConstraint*>& constraints = program.constraints();
+		for (std::size_t i = 0; i < constraints.size(); ++i) {
+			const std::unordered_map<int, double>& coeffs = constraints[i]->coefficients();
+			if (coeffs.empty())
+				continue;
+			std::size_t first = find_root(parent, coeffs.begin()->first);
+			for (std::unordered_map<int, double>::const_iterator it = coeffs.begin(); it != coeffs.end(); ++it) {
+				std::size_t root = find_root(parent, it->first);
+				if (root != first)
+					parent[root] = first;
+			}
+		}
+
+		groups.clear();
+		std::vector<int> root_group(num_variables, -1);
+		std::vector<int> variable_group(num_variables);
+		for (std::size_t i = 0; i < num_variables; ++i) {
+			std::size_t root = find_root(parent, i);
+			if (root_group[root] == -1) {
+				root_group[root] = static_cast<int>(groups.size());
+				groups.push_back(std::vector<int>());
+			}
+			variable_group[i] = root_group[root];
+			groups[root_group[root]].push_back(static_cast<int>(i));
+		}
+
+		constraint_group.assign(constraints.size(), -1);
+		for (std::size_t i = 0; i < constraints.size(); ++i) {
+			const std::unordered_map<int, double>& coeffs = constraints[i]->coefficients();
+			if (!coeffs.empty())
+				constraint_group[i] = variable_group[coeffs.begin()->first];
+		}
+	}
+
+}
+
+
+bool FaceSelection::compute_initial_solution(LinearProgramSolver::SolverName solver_name, std::vector<double>& X) {
+	StopWatch w;
+	std::size_t num_faces = supporting_point_num_.size();
+
+	// the faces improving the objective are selected, and the ones contributing the least are removed 
+	// first to close the surface (the complexity term is ignored)
+	const std::unordered_map<int, double>& coeffs = program_.objective()->coefficients();
+	std::vector<double> scores(num_faces, 0.0);
+	std::vector<char> selected(num_faces, 0);
+	for (std::size_t i = 0; i < num_faces; ++i) {
+		if (reduced_index_[i] < 0)
+			continue;
+		std::unordered_map<int, double>::const_iterator pos = coeffs.find(reduced_index_[i]);
+		scores[i] = (pos != coeffs.end()) ? -pos->second : 0.0;
+		selected[i] = (scores[i] > 0);
+	}
+
+	if (initial_solution_ == LP_ROUNDING && program_.num_variables() > 0) {
+		LinearProgramSolver solver;
+		solver.set_verbose(false);
+		if (!solver.solve(&program_, solver_name, std::vector<double>(), true)) {
+			Logger::warn("-") << "failed solving the linear relaxation (no initial solution)" << std::endl;
+			return false;
+		}
+		const std::vector<double>& values = solver.solution();
+		for (std::size_t i = 0; i < num_faces; ++i) {
+			if (reduced_index_[i] < 0)
+				continue;
+			scores[i] = values[reduced_index_[i]];
+			selected[i] = (scores[i] >= 0.5);
+		}
+	}
+
+	std::size_t idx = 0;
+	MapFacetAttribute<std::size_t>	facet_indices(model_);
+	FOR_EACH_FACET(Map, model_, it) {
+		Map::Facet* f = it;
+		facet_indices[f] = idx;
+		++idx;
+	}
+	FanIncidence incidence;
+	build_fan_incidence(adjacency_, facet_indices, num_faces, incidence);
+	facet_indices.unbind();
+
+	std::vector<char> excluded(num_faces, 0);
+	for (std::size_t i = 0; i < num_faces; ++i)
+		excluded[i] = (reduced_index_[i] < 0);
+	double threshold = (initial_solution_ == LP_ROUNDING) ? 0.5 : 0.0;
+	std::size_t num_added = 0, num_removed = 0;
+	close_surface(adjacency_, incidence, scores, threshold, excluded, selected, num_added, num_removed);
+
+	// the edge variables follow from the faces: an edge is used if it has two selected faces, and it is
+	// sharp if the two faces are not coplanar
+	X.assign(reduced_index_.size(), 0.0);
+	std::size_t num_selected = 0;
+	for (std::size_t i = 0; i < num_faces; ++i) {
+		if (selected[i]) {
+			X[i] = 1.0;
+			++num_selected;
+		}
+	}
+	for (std::size_t i = 0; i < adjacency_.size(); ++i) {
+		if (!adjacency_.usable(i))
+			continue;
+		std::size_t faces[2];
+		std::size_t num = 0;
+		for (std::size_t j = adjacency_.offsets()[i]; j < adjacency_.offsets()[i + 1] && num < 2; ++j) {
+			if (selected[incidence.faces[j]])
+				faces[num++] = incidence.faces[j];
+		}
+		if (num == 2) {
+			X[edge_usage_status_[i]] = 1.0;
+			if (supporting_planes_[faces[0]] != supporting_planes_[faces[1]])
+				X[edge_sharp_status_[i]] = 1.0;
+		}
+	}
+
+	double objective = 0.0;
+	for (std::size_t i = 0; i < reduced_index_.size(); ++i) {
+		if (reduced_index_[i] < 0 || X[i] == 0.0)
+			continue;
+		std::unordered_map<int, double>::const_iterator pos = coeffs.find(reduced_index_[i]);
+		if (pos != coeffs.end())
+			objective += pos->second;
+	}
+	++num_initial_solutions_;
+	if (num_selected == 0) {	// feasible, but useless as a hint
+		++num_empty_initial_solutions_;
+		Logger::warn("-") << "the initial solution is empty after closing the surface (" << num_empty_initial_solutions_ 
+			<< " of " << num_initial_solutions_ << " so far). No hint is given" << std::endl;
+		X.clear();
+		return false;
+	}
+	Logger::out("-") << "initial solution (" << (initial_solution_ == LP_ROUNDING ? "LP rounding" : "greedy") << "): " 
+		<< num_selected << " faces (" << num_added << " added and " << num_removed << " removed to close the surface), objective value " 
+		<< objective << ". " << w.elapsed() << " sec" << std::endl;
+	return true;
+}
+
+
+bool FaceSelection::solve(LinearProgramSolver::SolverName solver_name, const std::vector<double>& hint, std::vector<double>& X) {
+	// the variables removed by the presolve are 0
+	X.assign(reduced_index_.size(), 0.0);
+	if (program_.num_variables() == 0)
+		return true;
+
+	std::vector<double> program_hint;
+	if (!hint.empty()) {
+		program_hint.resize(program_.num_variables());
+		for (std::size_t i = 0; i < reduced_index_.size(); ++i) {
+			if (reduced_index_[i] >= 0)
+				program_hint[reduced_index_[i]] = hint[i];
+		}
+	}
+
+	std::vector<double> Y;
+	if (!solve_parts(solver_name, program_hint, Y))
+		return false;
+
+	for (std::size_t i = 0; i < reduced_index_.size(); ++i) {
+		if (reduced_index_[i] >= 0)
+			X[i] = Y[reduced_index_[i]];
+	}
+	return true;
+}
+
+
+bool FaceSelection::solve_parts(LinearProgramSolver::SolverName solver_name, const std::vector<double>& hint, std::vector<double>& X) {
+	std::vector< std::vector<int> > groups;
+	std::vector<int> constraint_group;
+	split_program(program_, groups, constraint_group);
+
+	if (groups.size() <= 1) {
+		LinearProgramSolver solver;
+		if (!solver.solve(&program_, solver_name, hint))
+			return false;
+		X = solver.solution();
+		if (solver.first_solution_time() >= 0)
+			Logger::out("-") << "first feasible solution found after " << solver.first_solution_time() << " sec" << std::endl;
+		return true;
+	}
+
+	// the program of each group (the variables are numbered locally)
+	const std::vector<Variable*>& variables = program_.variables();
+	std::vector<int> variable_group(variables.size());
+	std::vector<int> local_index(variables.size());
+	std::vector<LinearProgram*> parts(groups.size());
+	std::vector< std::vector<double> > part_hints(groups.size());
+	for (std::size_t k = 0; k < groups.size(); ++k) {
+		LinearProgram* part = new LinearProgram;
+		part->create_objective(program_.objective()->sense());
+		const std::vector<int>& group = groups[k];
+		for (std::size_t i = 0; i < group.size(); ++i) {
+			const Variable* v = variables[group[i]];
+			double lb, ub;
+			v->get_bounds(lb, ub);
+			part->create_variable(v->variable_type(), v->bound_type(), lb, ub);
+			variable_group[group[i]] = static_cast<int>(k);
+			local_index[group[i]] = static_cast<int>(i);
+			if (!hint.empty())
+				part_hints[k].push_back(hint[group[i]]);
+		}
+		parts[k] = part;
+	}
+
+	const std::vector<LinearConstraint*>& constraints = program_.constraints();
+	for (std::size_t i = 0; i < constraints.size(); ++i) {
+		if (constraint_group[i] == -1)
+			continue;
+		const LinearConstraint* c = constraints[i];
+		double lb, ub;
+		c->get_bounds(lb, ub);
+		LinearConstraint* part_c = parts[constraint_group[i]]->create_constraint(c->bound_type(), lb, ub);
+		const std::unordered_map<int, double>& coeffs = c->coefficients();
+		for (std::unordered_map<int, double>::const_iterator it = coeffs.begin(); it != coeffs.end(); ++it)
+			part_c->add_coefficient(local_index[it->first], it->second);
+	}
+
+	const std::unordered_map<int, double>& obj_coeffs = program_.objective()->coefficients();
+	for (std::unordered_map<int, double>::const_iterator it = obj_coeffs.begin(); it != obj_coeffs.end(); ++it)
+		parts[variable_group[it->first]]->objective()->add_coefficient(local_index[it->first], it->second);
+
+	// the largest parts first (for balancing the threads)
+	std::vector<std::size_t> tasks(groups.size());
+	for (std::size_t k = 0; k < groups.size(); ++k)
+		tasks[k] = k;
+	std::stable_sort(tasks.begin(), tasks.end(), [&groups](std::size_t a, std::size_t b) {
+		return groups[a].size() > groups[b].size();
+	});
+
+	std::vector< std::vector<double> > solutions(groups.size());
+	std::vector<double> first_solution_times(groups.size(), -1);
+	std::vector<char> solved(groups.size(), 0);
+	std::atomic<std::size_t> next_task(0);
+	auto worker = [&]() {
+		for (std::size_t t = next_task++; t < tasks.size(); t = next_task++) {
+			std::size_t k = tasks[t];
+			LinearProgramSolver solver;
+			solver.set_verbose(false);
+			if (solver.solve(parts[k], solver_name, part_hints[k])) {
+				solutions[k] = solver.solution();
+				first_solution_times[k] = solver.first_solution_time();
+				solved[k] = 1;
+			}
+		}
+	};
+
+	int num_threads = (num_threads_ > 0) ? num_threads_ : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+#ifdef HAS_GUROBI
+	if (solver_name == LinearProgramSolver::GUROBI)
+		num_threads = 1;	// the Gurobi environment is shared
+#endif
+	num_threads = std::min(num_threads, static_cast<int>(tasks.size()));
+	Logger::out("-") << "the binary program has " << groups.size() << " independent parts (the largest has " 
+		<< groups[tasks[0]].size() << " variables). Solving them with " << num_threads << " threads..." << std::endl;
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < num_threads; ++i)
+		threads.push_back(std::thread(worker));
+	worker();
+	for (std::size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+
+	bool status = true;
+	X.assign(variables.size(), 0.0);
+	for (std::size_t k = 0; k < groups.size(); ++k) {
+		if (!solved[k])
+			status = false;
+		else {
+			const std::vector<int>& group = groups[k];
+			for (std::size_t i = 0; i < group.size(); ++i)
+				X[group[i]] = solutions[k][i];
+		}
+		delete parts[k];
+	}
+
+	double first_solution_time = *std::max_element(first_solution_times.begin(), first_solution_times.end());
+	if (first_solution_time >= 0)
+		Logger::out("-") << "first feasible solutions of the parts found within " << first_solution_time << " sec" << std::endl;
+	return status;
+}
+
+
+// the halfedge of face 'f' (of a copy of the mesh) having the same end points as 'e'
+static Map::Halfedge* corresponding_halfedge(Map::Facet* f, Map::Halfedge* e) {
+	Map::Halfedge* h = f->halfedge();
+	do {
+		if (distance2(h->vertex()->point(), e->vertex()->point()) == 0 &&
+			distance2(h->prev()->vertex()->point(), e->prev()->vertex()->point()) == 0)
+			return h;
+		h = h->next();
+	} while (h != f->halfedge());
+	return nullptr;
+}
+
+
+void FaceSelection::apply_solution(Map* mesh, const std::vector<double>& X) {
+	typedef typename HypothesisGenerator::SuperEdge SuperEdge;
+
+	std::size_t idx = 0;
+	MapFacetAttribute<std::size_t>	facet_indices(model_);
+	FOR_EACH_FACET(Map, model_, it) {
+		Map::Facet* f = it;
+		facet_indices[f] = idx;
+		++idx;
+	}
+
+	std::vector<Map::Facet*> facets;
+	FOR_EACH_FACET(Map, mesh, it)
+		facets.push_back(it);
+
+	// the sharp edges are collected before the faces are deleted. The edges of a copy are found by 
+	// their end points in the corresponding face.
+	std::vector<Map::Halfedge*> sharp_edges;
+	for (std::size_t i = 0; i < adjacency_.size(); ++i) {
+		const SuperEdge& fan = adjacency_[i];
+		if (!adjacency_.usable(i))
+			continue;
+
+		std::size_t idx_sharp_var = edge_sharp_status_[i];
+		if (static_cast<int>(X[idx_sharp_var]) == 1) {
+			for (std::size_t j = 0; j < fan.size(); ++j) {
+				Map::Halfedge* e = fan[j];
+				std::size_t fid = facet_indices[e->facet()];
+				// if (static_cast<int>(X[fid]) == 1) { // Liangliang: be careful, floating point!!!
+				if (static_cast<int>(std::round(X[fid])) == 1) {
+					if (mesh != model_)
+						e = corresponding_halfedge(facets[fid], e);
+					if (e)
+						sharp_edges.push_back(e);
+					break;
+				}
+			}
+		}
+	}
+	facet_indices.unbind();
+
+	// mark results
+	std::vector<Map::Facet*> to_delete;
+	for (std::size_t fid = 0; fid < facets.size(); ++fid) {
+		//if (static_cast<int>(X[fid]) == 0) { // Liangliang: be careful, floating point!!!
+		//if (static_cast<int>(X[fid]) != 1) { // Liangliang: be careful, floating point!!!
+		if (static_cast<int>(std::round(X[fid])) == 0) {
+			to_delete.push_back(facets[fid]);
+		}
+	}
+
+	MapEditor editor(mesh);
+	for (std::size_t i = 0; i < to_delete.size(); ++i) {
+		Map::Facet* f = to_delete[i];
+		editor.erase_facet(f->halfedge());
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	// mark the sharp edges
+	MapHalfedgeAttribute<bool> edge_is_sharp(mesh, "SharpEdge");
+	FOR_EACH_EDGE(Map, mesh, it)
+		edge_is_sharp[it] = false;
+	for (std::size_t i = 0; i < sharp_edges.size(); ++i)
+		edge_is_sharp[sharp_edges[i]] = true;
+}
+
+
+void FaceSelection::optimize(HypothesisGenerator* generator,
+                             LinearProgramSolver::SolverName solver_name,
+                             double data_fitting,
+                             double model_coverage,
+                             double model_complexity)
+ {
+    if (pset_ == nullptr || model_ == nullptr)
+		return;
+
+	if (!bind_attributes()) {
+		unbind_attributes();
+		return;
+	}
+
+	// the faces will be deleted, so a previous session is no longer valid
+	generator_ = nullptr;
+	last_solution_.clear();
+    adjacency_ = generator->extract_adjacency(model_);
+
+	//-------------------------------------
+
+	StopWatch w;
+    Logger::out("-") << "face selection..." << std::endl;
+
+	//-------------------------------------
+
+	Logger::out("-") << "formulating binary program...." << std::endl;
+	w.start();
+
+	formulate_constraints();
+	formulate_objective(data_fitting, model_coverage, model_complexity);
+
 	Logger::out("-") << "formulating binary program done. " << w.elapsed() << " sec" << std::endl;
 
 	//////////////////////////////////////////////////////////////////////////
@@ -265,82 +929,177 @@ void FaceSelection::optimize(HypothesisGenerator* generator,
     program_.save("D:/tmp/bunny.lp");
 #endif
 
-	LinearProgramSolver solver;
-	if (solver.solve(&program_, solver_name)) {
+	std::vector<double> hint;
+	if (initial_solution_ != NONE)
+		compute_initial_solution(solver_name, hint);
+
+	std::vector<double> X;
+	if (solve(solver_name, hint, X)) {
 		Logger::out("-") << "solving the binary program done. " << w.elapsed() << " sec" << std::endl;
+		apply_solution(model_, X);
+	}
+	else {
+        Logger::out("-") << "solving the binary program failed. " << w.elapsed() << " sec." << std::endl;
+	}
 
-		// mark results
-		const std::vector<double>& X = solver.solution();
-		std::vector<Map::Facet*> to_delete;
-		FOR_EACH_FACET(Map, model_, it) {
-			Map::Facet* f = it;
-			std::size_t fid = facet_indices[f];
-			//if (static_cast<int>(X[fid]) == 0) { // Liangliang: be careful, floating point!!!
-			//if (static_cast<int>(X[fid]) != 1) { // Liangliang: be careful, floating point!!!
-			if (static_cast<int>(std::round(X[fid])) == 0) {
-				to_delete.push_back(f);
-			}
-		}
+	unbind_attributes();
+	program_.clear();
+	adjacency_ = HypothesisGenerator::Adjacency();
 
-		MapEditor editor(model_);
-		for (std::size_t i = 0; i < to_delete.size(); ++i) {
-			Map::Facet* f = to_delete[i];
-			editor.erase_facet(f->halfedge());
-		}
+    // to have consistent orientation for the final model
+    re_orient(model_, generator);
+}
+
+
+bool FaceSelection::formulate(HypothesisGenerator* generator) {
+	generator_ = nullptr;
+	last_solution_.clear();
+	if (pset_ == nullptr || model_ == nullptr || generator == nullptr)
+		return false;
+
+	if (!bind_attributes()) {
+		unbind_attributes();
+		return false;
+	}
+
+	StopWatch w;
+	Logger::out("-") << "formulating binary program...." << std::endl;
+
+	adjacency_ = generator->extract_adjacency(model_);
+	formulate_constraints();
+	unbind_attributes();
+
+	Logger::out("-") << "formulating binary program done. " << w.elapsed() << " sec" << std::endl;
 
-		//////////////////////////////////////////////////////////////////////////
+	generator_ = generator;
+	return true;
+}
+
+
+Map* FaceSelection::select(LinearProgramSolver::SolverName solver_name, double data_fitting, double model_coverage, double model_complexity) {
+	if (generator_ == nullptr) {
+		Logger::err("-") << "please formulate the binary program first" << std::endl;
+		return nullptr;
+	}
+
+	StopWatch w;
+	formulate_objective(data_fitting, model_coverage, model_complexity);
+
+	// the constraints are not changed, so the previous solution is still feasible
+	std::vector<double> hint = last_solution_;
+	if (hint.empty() && initial_solution_ != NONE)
+		compute_initial_solution(solver_name, hint);
+
+	Logger::out("-") << "solving the binary program" << (last_solution_.empty() ? "" : " (warm start)") << ". Please wait..." << std::endl;
+	std::vector<double> X;
+	if (!solve(solver_name, hint, X)) {
+		Logger::out("-") << "solving the binary program failed. " << w.elapsed() << " sec." << std::endl;
+		return nullptr;
+	}
+	Logger::out("-") << "solving the binary program done. " << w.elapsed() << " sec" << std::endl;
+	last_solution_ = X;
+
+	Map* mesh = Geom::duplicate(model_);
+	apply_solution(mesh, last_solution_);
+
+    // to have consistent orientation for the final model
+	re_orient(mesh, generator_);
+	return mesh;
+}
 
-		// mark the sharp edges
-		MapHalfedgeAttribute<bool> edge_is_sharp(model_, "SharpEdge");
-		FOR_EACH_EDGE(Map, model_, it)
-			edge_is_sharp[it] = false;
 
+
+namespace {
+
+	// Propagates the orientation of a face to the faces sharing an edge with it (breadth first). Two 
+	// faces sharing an edge are consistently oriented if they traverse the edge in opposite directions, 
+	// so the 'flip' of each face (i.e., to be reoriented or not) is determined by the flip of any face in
+	// its connected component. Of the two possible choices of a component, the one flipping fewer faces 
+	// is taken. The faces of a component that can't be oriented consistently (e.g., a Moebius strip) are
+	// not flipped. Returns the number of such components.
+	std::size_t propagate_orientation(
+		const HypothesisGenerator::Adjacency& adjacency,
+		const MapFacetAttribute<std::size_t>& facet_indices,
+		std::size_t num_faces,
+		std::vector<char>& flip
+	)
+	{
+		// the neighbors of each face in a flat layout, with the parity of the edge
+		std::vector<std::size_t> offsets(num_faces + 1, 0);
+		for (std::size_t i = 0; i < adjacency.size(); ++i) {
+			const HypothesisGenerator::SuperEdge& fan = adjacency[i];
+			++offsets[facet_indices[fan[0]->facet()] + 1];
+			++offsets[facet_indices[fan[1]->facet()] + 1];
+		}
+		for (std::size_t i = 0; i < num_faces; ++i)
+			offsets[i + 1] += offsets[i];
+
+		std::vector< std::pair<std::size_t, char> > neighbors(offsets.back());
+		std::vector<std::size_t> pos(offsets.begin(), offsets.end() - 1);
 		for (std::size_t i = 0; i < adjacency.size(); ++i) {
-			const SuperEdge& fan = adjacency[i];
-			if (fan.size() != 4)
+			const HypothesisGenerator::SuperEdge& fan = adjacency[i];
+			MapTypes::Halfedge* h0 = fan[0];
+			MapTypes::Halfedge* h1 = fan[1];
+			std::size_t fid0 = facet_indices[h0->facet()];
+			std::size_t fid1 = facet_indices[h1->facet()];
+			char parity = (dot(Geom::vector(h0), Geom::vector(h1)) > 0) ? 1 : 0; // 1: one must flip
+			neighbors[pos[fid0]++] = std::make_pair(fid1, parity);
+			neighbors[pos[fid1]++] = std::make_pair(fid0, parity);
+		}
+
+		std::size_t num_inconsistent = 0;
+		flip.assign(num_faces, 0);
+		std::vector<char> visited(num_faces, 0);
+		std::vector<std::size_t> component;
+		for (std::size_t seed = 0; seed < num_faces; ++seed) {
+			if (visited[seed])
 				continue;
 
-			std::size_t idx_sharp_var = edge_sharp_status[&fan];
-			if (static_cast<int>(X[idx_sharp_var]) == 1) {
-				for (std::size_t j = 0; j < fan.size(); ++j) {
-					Map::Halfedge* e = fan[j];
-					Map::Facet* f = e->facet();
-					if (f) { // some faces may be deleted
-						std::size_t fid = facet_indices[f];
-						// if (static_cast<int>(X[fid]) == 1) { // Liangliang: be careful, floating point!!!
-						if (static_cast<int>(std::round(X[fid])) == 1) {
-							edge_is_sharp[e] = true;
-							break;
-						}
+			component.clear();
+			component.push_back(seed);
+			visited[seed] = 1;
+			bool consistent = true;
+			for (std::size_t k = 0; k < component.size(); ++k) {	// the component is the queue
+				std::size_t f = component[k];
+				for (std::size_t j = offsets[f]; j < offsets[f + 1]; ++j) {
+					std::size_t g = neighbors[j].first;
+					char expected = flip[f] ^ neighbors[j].second;
+					if (!visited[g]) {
+						visited[g] = 1;
+						flip[g] = expected;
+						component.push_back(g);
 					}
+					else if (flip[g] != expected)
+						consistent = false;
 				}
 			}
-		}
-	}
-	else {
-        Logger::out("-") << "solving the binary program failed. " << w.elapsed() << " sec." << std::endl;
-	}
 
-    // to have consistent orientation for the final model
-    re_orient(generator, solver_name);
+			if (!consistent) {
+				for (std::size_t k = 0; k < component.size(); ++k)
+					flip[component[k]] = 0;
+				++num_inconsistent;
+				continue;
+			}
 
-	facet_attrib_supporting_vertex_group_.unbind();
-	facet_attrib_supporting_point_num_.unbind();
-	facet_attrib_facet_area_.unbind();
-	facet_attrib_covered_area_.unbind();
+			std::size_t num_flipped = 0;
+			for (std::size_t k = 0; k < component.size(); ++k)
+				num_flipped += flip[component[k]];
+			if (num_flipped * 2 > component.size()) {
+				for (std::size_t k = 0; k < component.size(); ++k)
+					flip[component[k]] ^= 1;
+			}
+		}
+		return num_inconsistent;
+	}
 
-	vertex_source_planes_.unbind();
-	edge_source_planes_.unbind();
-	facet_attrib_supporting_plane_.unbind();
 }
 
 
-
-void FaceSelection::re_orient(HypothesisGenerator* generator, LinearProgramSolver::SolverName solver_name) {
-    if (model_ == nullptr)
+void FaceSelection::re_orient(Map* mesh, HypothesisGenerator* generator) {
+    if (mesh == nullptr)
         return;
 
-    auto adjacency = generator->extract_adjacency(model_);
+    auto adjacency = generator->extract_adjacency(mesh);
 
 #if 1
     // check if input is legal
@@ -354,8 +1113,8 @@ void FaceSelection::re_orient(HypothesisGenerator* generator, LinearProgramSolve
 #endif
 
     std::size_t idx = 0;
-    MapFacetAttribute<std::size_t>	facet_indices(model_);
-    FOR_EACH_FACET(Map, model_, it) {
+    MapFacetAttribute<std::size_t>	facet_indices(mesh);
+    FOR_EACH_FACET(Map, mesh, it) {
         Map::Facet* f = it;
         facet_indices[f] = idx;
         ++idx;
@@ -368,111 +1127,45 @@ void FaceSelection::re_orient(HypothesisGenerator* generator, LinearProgramSolve
 
     //-------------------------------------
 
-    // binary variables:
-    // x[0] ... x[num_faces - 1] : binary labels of all the input faces
-
-    Logger::out("-") << "formulating binary program...." << std::endl;
-    w.start();
-
-    program_.clear();
-
-    const std::vector<Variable*>& variables = program_.create_n_variables(model_->size_of_facets());
-    for (std::size_t i = 0; i < variables.size(); ++i) {
-        Variable* v = variables[i];
-        v->set_variable_type(Variable::BINARY);
+    // The orientation is a 2-coloring of the faces, which is propagated along the edges in linear time.
+    // No orientation satisfies all the edges of an inconsistent part, so its faces are left as they are.
+    std::vector<char> flip;
+    std::size_t num_inconsistent = propagate_orientation(adjacency, facet_indices, mesh->size_of_facets(), flip);
+    if (num_inconsistent > 0)
+        Logger::warn("-") << num_inconsistent << " parts of the model can't be oriented consistently (not reoriented)" << std::endl;
+    Logger::out("-") << "orientation propagated. " << w.elapsed() << " sec" << std::endl;
+    facet_indices.unbind();
+
+    std::vector<Map::Facet*> facets;
+    FOR_EACH_FACET(Map, mesh, it)
+        facets.push_back(it);
+
+    MapEditor editor(mesh);
+    for (std::size_t fid = 0; fid < facets.size(); ++fid) {
+        if (flip[fid])
+            editor.reorient_facet(facets[fid]->halfedge());
     }
-
-    LinearObjective* objective = program_.create_objective(LinearObjective::MINIMIZE);
-    FOR_EACH_FACET(Map, model_, it) {
-        Map::Facet* f = it;
-        std::size_t var_idx = facet_indices[f];
-        objective->add_coefficient(var_idx, 1.0);
-    }
-
-    //////////////////////////////////////////////////////////////////////////
-
-    typedef typename HypothesisGenerator::SuperEdge SuperEdge;
-
-    // Add constraints:
-    for (std::size_t i = 0; i < adjacency.size(); ++i) {
-        const SuperEdge& fan = adjacency[i];
-        assert(fan.size() == 2);
-
-        MapTypes::Halfedge* h0 = fan[0];
-        MapTypes::Halfedge* h1 = fan[1];
-
-        MapTypes::Facet* f0 = h0->facet();
-        MapTypes::Facet* f1 = h1->facet();
-        std::size_t var_idx0 = facet_indices[f0];
-        std::size_t var_idx1 = facet_indices[f1];
-
-        if (dot(Geom::vector(h0), Geom::vector(h1)) > 0) { // one must flip: x_i + x_j = 1
-            LinearConstraint* c = program_.create_constraint(LinearConstraint::FIXED, 1.0, 1.0);
-            c->add_coefficient(var_idx0, 1.0);
-            c->add_coefficient(var_idx1, 1.0);
-        }
-        else { // both flip, or both not: x_i - x_j = 0
-            LinearConstraint* c = program_.create_constraint(LinearConstraint::FIXED, 0.0, 0.0);
-            c->add_coefficient(var_idx0,  1.0);
-            c->add_coefficient(var_idx1, -1.0);
+    // Note: A border edge is now parallel to its opposite edge.
+    // We scan all border edges for this property. If it holds, we
+    // reorient the associated hole and search again until no border
+    // edge with that property exists any longer. Then, all holes are
+    // reoriented.
+    FOR_EACH_HALFEDGE(Map, mesh, it) {
+        if (it->is_border() && it->vertex() == it->opposite()->vertex()) {
+            editor.reorient_facet(it);
         }
     }
-
-    Logger::out("-") << "#total variables: " << program_.variables().size() << std::endl;
-    Logger::out("-") << "#total constraints: " << program_.constraints().size() << std::endl;
-    Logger::out("-") << "formulating binary program done. " << w.elapsed() << " sec" << std::endl;
-
-    //////////////////////////////////////////////////////////////////////////
-
-    // Optimize model
-    Logger::out("-") << "solving the binary program. Please wait..." << std::endl;
-    w.start();
-
-    LinearProgramSolver solver;
-    if (solver.solve(&program_, solver_name)) {
-        Logger::out("-") << "solving the binary program done. " << w.elapsed() << " sec" << std::endl;
-
-        MapFacetAttribute<bool> visited(model_);
-        FOR_EACH_FACET(Map, model_, it) {
-            Map::Facet* f = it;
-            visited[f] = false;
-        }
-
-        const std::vector<double>& X = solver.solution();
-        MapEditor editor(model_);
-        FOR_EACH_FACET(Map, model_, it) {
-            Map::Facet* f = it;
-            std::size_t fid = facet_indices[f];
-            if (static_cast<int>(std::round(X[fid])) == 1 && !visited[f]) {
-                editor.reorient_facet(f->halfedge());
-                visited[f] = true;
-            }
-        }
-        // Note: A border edge is now parallel to its opposite edge.
-        // We scan all border edges for this property. If it holds, we
-        // reorient the associated hole and search again until no border
-        // edge with that property exists any longer. Then, all holes are
-        // reoriented.
-        FOR_EACH_HALFEDGE(Map, model_, it) {
-            if (it->is_border() && it->vertex() == it->opposite()->vertex()) {
-                editor.reorient_facet(it);
-            }
-        }
-        model_->compute_facet_normals();
-
-        // try to make sure all normals pointing outward
-        vec3 normal;
-        float max_z = -std::numeric_limits<float>::max();
-        FOR_EACH_VERTEX_CONST(Map, model_, it) {
-            if (it->point().z > max_z) {
-                max_z = it->point().z;
-                normal = Geom::vertex_normal(it);
-            }
+    mesh->compute_facet_normals();
+
+    // try to make sure all normals pointing outward
+    vec3 normal;
+    float max_z = -std::numeric_limits<float>::max();
+    FOR_EACH_VERTEX_CONST(Map, mesh, it) {
+        if (it->point().z > max_z) {
+            max_z = it->point().z;
+            normal = Geom::vertex_normal(it);
         }
-        if (normal.z < 0) // reorient the entire model
-            editor.inside_out(true);
-    }
-    else {
-        Logger::out("-") << "solving the binary program failed. " << w.elapsed() << " sec." << std::endl;
     }
+    if (normal.z < 0) // reorient the entire model
+        editor.inside_out(true);
 }
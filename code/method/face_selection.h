@@ -18,6 +18,8 @@
 #define _FACE_SELECTION_H_
 
 #include <method/method_common.h>
+#include <method/source_planes.h>
+#include <method/hypothesis_generator.h>
 #include <math/math_types.h>
 #include <math/linear_program.h>
 #include <math/linear_program_solver.h>
@@ -32,7 +34,6 @@
 class Map;
 class PointSet;
 class VertexGroup;
-class HypothesisGenerator;
 
 namespace MapTypes {
 	class Vertex;
@@ -44,6 +45,14 @@ namespace MapTypes {
 // to determine if a face should be selected or not
 class METHOD_API FaceSelection
 {
+public:
+	// the initial solution given to the solver (when there is no previous solution to start from)
+	enum InitialSolution {
+		NONE,			// the solver finds its first solution itself
+		GREEDY,			// the faces improving the objective, repaired into a closed surface
+		LP_ROUNDING		// the rounded solution of the linear relaxation, repaired into a closed surface
+	};
+
 public:
 	FaceSelection(PointSet* pset, Map* model);
 	~FaceSelection() {}
@@ -55,15 +64,81 @@ public:
                   double model_complexity    // weight for model complexity term)
     );
 
+	// A selection session, e.g., for tuning the weights with the GUI or in parameter sweeps. Only the 
+	// objective of the binary program depends on the weights, so formulate() extracts the adjacency and 
+	// builds the constraints once, and each select() only updates the objective and warm-starts the 
+	// solver with the previous solution. Unlike optimize(), the candidate faces (i.e., 'model') are not
+	// modified: select() returns a new mesh made of the selected faces (nil if the solver fails).
+	// NOTE: the session is valid until 'model' is changed (e.g., by optimize()).
+	bool formulate(HypothesisGenerator* generator);
+	Map* select(LinearProgramSolver::SolverName solver_name, double data_fitting, double model_coverage, double model_complexity);
+
+	// number of threads for solving the independent parts of the binary program (default is 1, i.e., 
+	// sequential). A value of 0 means using all the hardware threads. The result does not depend on it.
+	void set_num_threads(int n) { num_threads_ = n; }
+	int  num_threads() const { return num_threads_; }
+
+	// a closed surface computed by a fast heuristic (default is NONE) helps the solver find a good 
+	// solution early on large inputs. The time to the first solution is reported in the log.
+	void set_initial_solution(InitialSolution s) { initial_solution_ = s; }
+	InitialSolution initial_solution() const { return initial_solution_; }
+
 protected:
     // NOTE: the adjacency is the one extracted after the face optimization step
-    void re_orient(HypothesisGenerator* generator, LinearProgramSolver::SolverName solver_name);
+    void re_orient(Map* mesh, HypothesisGenerator* generator);
+
+private:
+	bool bind_attributes();
+	void unbind_attributes();
+
+	// creates the variables and the constraints of the binary program for the candidate faces. The 
+	// variables fixed by the structure of the candidate faces (i.e., the faces that can't be paired 
+	// with other faces at all their edges) are removed.
+	void formulate_constraints();
+
+	// (re)sets the objective of the binary program for the weights
+	void formulate_objective(double data_fitting, double model_coverage, double model_complexity);
+
+	// Computes the initial solution 'X' (see InitialSolution) for the current objective. 'X' has a 
+	// value for each variable of the formulation and it satisfies all the constraints. Returns false 
+	// (and 'X' is empty) if it fails or if no face is left selected.
+	bool compute_initial_solution(LinearProgramSolver::SolverName solver_name, std::vector<double>& X);
+
+	// Solves program_. The 'hint' (optional) and the solution 'X' have a value for each variable of the 
+	// formulation, including the ones removed by the presolve.
+	bool solve(LinearProgramSolver::SolverName solver_name, const std::vector<double>& hint, std::vector<double>& X);
+
+	// Solves program_ as it is ('hint' is optional). The program is split into its independent parts, 
+	// i.e., the groups of faces (and their edges) not linked by any shared edge, e.g., the separate 
+	// buildings of a scene. The parts are solved as separate programs (concurrently if multiple threads
+	// are used) and 'X' returns the solution of the whole program.
+	bool solve_parts(LinearProgramSolver::SolverName solver_name, const std::vector<double>& hint, std::vector<double>& X);
+
+	// deletes the faces that are not selected by 'X' and marks the sharp edges. 'mesh' is either 
+	// model_ or a copy of it (with the faces in the same order).
+	void apply_solution(Map* mesh, const std::vector<double>& X);
 
 private:
 	PointSet* pset_;
 	Map*      model_;
 
 	LinearProgram	program_;
+	int				num_threads_;
+	InitialSolution	initial_solution_;
+	std::size_t		num_initial_solutions_;			// the initial solutions computed so far ...
+	std::size_t		num_empty_initial_solutions_;	// ... and the ones left empty by the repair
+
+	// the formulation: the adjacency of the candidate faces, the variables of the usable super edges
+	// (see Adjacency::usable()), and the quality measures of the faces in their order
+	HypothesisGenerator*				generator_;
+	HypothesisGenerator::Adjacency		adjacency_;
+	std::vector<std::size_t>			edge_usage_status_;
+	std::vector<std::size_t>			edge_sharp_status_;
+	std::vector<int>					reduced_index_;		// the index in program_ of each variable (-1 if removed by the presolve)
+	std::vector<double>					supporting_point_num_;
+	std::vector<double>					uncovered_area_;
+	std::vector<Plane3d*>				supporting_planes_;
+	std::vector<double>					last_solution_;		// the hint of the next select()
 
 	MapFacetAttribute<VertexGroup*> facet_attrib_supporting_vertex_group_;
 	MapFacetAttribute<double>		facet_attrib_supporting_point_num_;
@@ -71,8 +146,8 @@ private:
 	MapFacetAttribute<double>		facet_attrib_covered_area_;
 
 	MapFacetAttribute<Plane3d*>					facet_attrib_supporting_plane_;
-	MapVertexAttribute< std::set<Plane3d*> >	vertex_source_planes_;
-	MapHalfedgeAttribute< std::set<Plane3d*> >	edge_source_planes_;
+	MapVertexAttribute<VertexSourcePlanes>		vertex_source_planes_;
+	MapHalfedgeAttribute<EdgeSourcePlanes>		edge_source_planes_;
 };
 
 #endif
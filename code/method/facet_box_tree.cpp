@@ -0,0 +1,121 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#include <method/facet_box_tree.h>
+#include <model/map.h>
+#include <model/map_circulators.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+// the maximum number of facets in a leaf
+static const std::size_t max_leaf_size = 4;
+
+
+FacetBoxTree::FacetBoxTree(const std::vector<MapTypes::Facet*>& facets, float padding)
+	: padding_(padding)
+{
+	boxes_.resize(facets.size());
+	indices_.resize(facets.size());
+	for (std::size_t i = 0; i < facets.size(); ++i) {
+		FacetHalfedgeCirculator cir(facets[i]);
+		for (; !cir->end(); ++cir)
+			boxes_[i].add_point(cir->halfedge()->vertex()->point());
+		indices_[i] = i;
+	}
+
+	if (!facets.empty())
+		build(0, facets.size());
+}
+
+
+int FacetBoxTree::build(std::size_t begin, std::size_t end) {
+	int id = static_cast<int>(nodes_.size());
+	nodes_.push_back(Node());
+
+	Node node;
+	node.begin = begin;
+	node.end = end;
+	node.left = node.right = -1;
+	for (std::size_t i = begin; i < end; ++i)
+		node.box.add_box(boxes_[indices_[i]]);
+
+	if (end - begin > max_leaf_size) {
+		// split at the median of the box centers along the longest axis
+		unsigned int axis = 0;
+		if (node.box.height() > node.box.width())
+			axis = 1;
+		if (node.box.depth() > std::max(node.box.width(), node.box.height()))
+			axis = 2;
+
+		const std::vector<Box3d>& boxes = boxes_;
+		std::size_t mid = begin + (end - begin) / 2;
+		std::nth_element(indices_.begin() + begin, indices_.begin() + mid, indices_.begin() + end,
+			[&boxes, axis](std::size_t a, std::size_t b) {
+				return boxes[a].min(axis) + boxes[a].max(axis) < boxes[b].min(axis) + boxes[b].max(axis);
+			}
+		);
+
+		node.left = build(begin, mid);
+		node.right = build(mid, end);
+	}
+
+	nodes_[id] = node;
+	return id;
+}
+
+
+bool FacetBoxTree::plane_intersects_box(const Plane3d& plane, const Box3d& box, float padding) {
+	double a = plane.a(), b = plane.b(), c = plane.c(), d = plane.d();
+	const vec3& center = box.center();
+	double ex = 0.5 * box.width(), ey = 0.5 * box.height(), ez = 0.5 * box.depth();
+
+	// the signed distance of the center and the projected half size of the box (both scaled by |n|)
+	double s = a * center.x + b * center.y + c * center.z + d;
+	double r = std::fabs(a) * ex + std::fabs(b) * ey + std::fabs(c) * ez;
+	double n = std::sqrt(a * a + b * b + c * c);
+	return std::fabs(s) <= r + padding * n;
+}
+
+
+void FacetBoxTree::facets_intersecting(const Plane3d& plane, std::vector<std::size_t>& indices) const {
+	indices.clear();
+	if (nodes_.empty())
+		return;
+
+	std::vector<int> stack(1, 0);
+	while (!stack.empty()) {
+		const Node& node = nodes_[stack.back()];
+		stack.pop_back();
+		if (!plane_intersects_box(plane, node.box, padding_))
+			continue;
+
+		if (node.left == -1) {
+			for (std::size_t i = node.begin; i < node.end; ++i) {
+				std::size_t idx = indices_[i];
+				if (plane_intersects_box(plane, boxes_[idx], padding_))
+					indices.push_back(idx);
+			}
+		}
+		else {
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+
+	std::sort(indices.begin(), indices.end());
+}
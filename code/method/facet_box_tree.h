@@ -0,0 +1,62 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef _FACET_BOX_TREE_H_
+#define _FACET_BOX_TREE_H_
+
+#include <method/method_common.h>
+#include <math/math_types.h>
+
+#include <vector>
+
+
+namespace MapTypes {
+	class Facet;
+}
+
+
+// An AABB tree of the bounding boxes of a set of facets. It is used to quickly collect the 
+// facets that may intersect a plane, instead of testing the plane against all the facets.
+class METHOD_API FacetBoxTree
+{
+public:
+	// 'padding' enlarges the boxes, so that facets within this distance to a plane are also 
+	// reported (e.g., to account for snapping).
+	FacetBoxTree(const std::vector<MapTypes::Facet*>& facets, float padding = 0.0f);
+
+	// collects the indices (in increasing order) of the facets whose box intersects the plane
+	void facets_intersecting(const Plane3d& plane, std::vector<std::size_t>& indices) const;
+
+	// returns true if the plane intersects the box enlarged by 'padding'
+	static bool plane_intersects_box(const Plane3d& plane, const Box3d& box, float padding);
+
+private:
+	struct Node {
+		Box3d		box;
+		std::size_t begin, end;	// the range of the facets (in 'indices_') in this node
+		int			left, right;// children (-1 for leaves)
+	};
+
+	int build(std::size_t begin, std::size_t end);
+
+private:
+	std::vector<Box3d>			boxes_;		// the box of each facet
+	std::vector<std::size_t>	indices_;	// facet indices, grouped by the leaves
+	std::vector<Node>			nodes_;		// nodes_[0] is the root
+	float						padding_;
+};
+
+#endif
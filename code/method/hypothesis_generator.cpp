@@ -19,6 +19,9 @@
 #include <method/alpha_shape.h>
 #include <method/method_global.h>
 #include <method/alpha_shape_mesh.h>
+#include <method/facet_box_tree.h>
+#include <method/polygon_grid_2d.h>
+#include <method/raster_coverage.h>
 #include <basic/progress.h>
 #include <basic/logger.h>
 #include <basic/assertions.h>
@@ -37,6 +40,11 @@
 #include <CGAL/Projection_traits_xy_3.h>
 
 #include <algorithm>
+#include <cfloat>
+#include <thread>
+#include <atomic>
+#include <queue>
+#include <fstream>
 
 
 
@@ -47,6 +55,12 @@
 
 HypothesisGenerator::HypothesisGenerator(PointSet* pset)
 	: pset_(pset)
+	, num_threads_(1)
+	, coverage_estimator_(ALPHA_SHAPE)
+	, cutting_method_(INCREMENTAL_CUT)
+	, bbox_mesh_(nil)
+	, kinetic_(false)
+	, avg_spacing_(0)
 {
 }
 
@@ -57,52 +71,117 @@ HypothesisGenerator::~HypothesisGenerator()
 }
 
 
-static std::list<unsigned int> points_on_plane(VertexGroup* g, const Plane3d& plane, float dist_threshold) {
-	std::list<unsigned int> result;
-
+// returns true if more than 'num_threshold' points of 'g' are within 'dist_threshold' to 'plane'
+static bool enough_points_on_plane(const VertexGroup* g, const Plane3d& plane, float dist_threshold, float num_threshold) {
 	const std::vector<vec3>& points = g->point_set()->points();
+	float sqr_dist_threshold = dist_threshold * dist_threshold;
+	std::size_t count = 0;
 	for (std::size_t i = 0; i < g->size(); ++i) {
-		int idx = g->at(i);
-		const vec3& p = points[idx];
-
-		float sdist = plane.squared_ditance(p);
-		float dist = std::sqrt(sdist);
-		if (dist < dist_threshold)
-			result.push_back(idx);
+		const vec3& p = points[g->at(i)];
+		if (plane.squared_ditance(p) < sqr_dist_threshold) {
+			++count;
+			if (count > num_threshold)
+				return true;
+		}
 	}
-	return result;
+	return false;
 }
 
-void HypothesisGenerator::merge(VertexGroup* g1, VertexGroup* g2) {
-	std::vector<VertexGroup::Ptr>& groups = pset_->groups();
-	const std::vector<vec3>& points = pset_->points();
 
-	std::vector<unsigned int> points_indices;
-	points_indices.insert(points_indices.end(), g1->begin(), g1->end());
-	points_indices.insert(points_indices.end(), g2->begin(), g2->end());
+VertexGroup::Ptr HypothesisGenerator::merge(VertexGroup* g1, VertexGroup* g2) {
+	// the moments of the merged group are simply the sum of those of the two groups
+	PointMoments3d moments = pset_->moments(g1);
+	moments.add(pset_->moments(g2));
 
 	VertexGroup::Ptr g = new VertexGroup;
-	g->insert(g->end(), points_indices.begin(), points_indices.end());
+	g->reserve(g1->size() + g2->size());
+	g->insert(g->end(), g1->begin(), g1->end());
+	g->insert(g->end(), g2->begin(), g2->end());
 	g->set_point_set(pset_);
 	g->set_color(fused_color(g1->color(), static_cast<float>(g1->size()), g2->color(), static_cast<float>(g2->size())));
+	g->set_moments(moments);
 	pset_->fit_plane(g);
-	groups.push_back(g);
+	return g;
+}
 
-	std::vector<VertexGroup::Ptr>::iterator pos = std::find(groups.begin(), groups.end(), g1);
-	if (pos != groups.end()) {
-		groups.erase(pos);
-	}
-	else {
-		Logger::err("-") << "fatal error: vertex group doesn't exist" << std::endl;
-	}
 
-	pos = std::find(groups.begin(), groups.end(), g2);
-	if (pos != groups.end()) {
-		groups.erase(pos);
-	}
-	else {
-		Logger::err("-") << "fatal error: vertex group doesn't exist" << std::endl;
-	}
+namespace {
+
+	// Buckets the (unit) normals of the segments into a regular grid, whose cell size is the chord 
+	// length of the angle threshold. So all the normals within the angle threshold to a normal n 
+	// are in the 27 cells around n (or around -n, since the orientations don't matter).
+	class NormalGrid
+	{
+	public:
+		NormalGrid(float max_angle) : cell_size_(2.0f * std::sin(max_angle * 0.5f)) {}
+
+		void insert(int id, const vec3& n) { cells_[cell(n)].push_back(id); }
+
+		void remove(int id, const vec3& n) {
+			std::vector<int>& ids = cells_[cell(n)];
+			std::vector<int>::iterator pos = std::find(ids.begin(), ids.end(), id);
+			if (pos != ids.end()) {
+				*pos = ids.back();
+				ids.pop_back();
+			}
+		}
+
+		// collects the ids of the normals that may be within the angle threshold to 'n'
+		void neighbors(const vec3& n, std::vector<int>& ids) const {
+			ids.clear();
+			for (int side = 0; side < 2; ++side) {
+				const vec3 q = (side == 0) ? n : -n;
+				int c[3] = { index(q.x), index(q.y), index(q.z) };
+				for (int i = -1; i <= 1; ++i) {
+					for (int j = -1; j <= 1; ++j) {
+						for (int k = -1; k <= 1; ++k) {
+							std::map<long long, std::vector<int> >::const_iterator pos = cells_.find(key(c[0] + i, c[1] + j, c[2] + k));
+							if (pos != cells_.end())
+								ids.insert(ids.end(), pos->second.begin(), pos->second.end());
+						}
+					}
+				}
+			}
+			std::sort(ids.begin(), ids.end());
+			ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		}
+
+	private:
+		int index(float v) const { return static_cast<int>(std::floor(v / cell_size_)); }
+		static long long key(int i, int j, int k) {
+			const long long offset = 1 << 20;
+			return ((i + offset) << 42) | ((j + offset) << 21) | (k + offset);
+		}
+		long long cell(const vec3& n) const { return key(index(n.x), index(n.y), index(n.z)); }
+
+	private:
+		float cell_size_;
+		std::map<long long, std::vector<int> > cells_;
+	};
+
+
+	// union-find (with path halving) of the segments
+	class SegmentUnion
+	{
+	public:
+		SegmentUnion(std::size_t num) : parent_(num) {
+			for (std::size_t i = 0; i < num; ++i)
+				parent_[i] = static_cast<int>(i);
+		}
+		int find(int i) {
+			while (parent_[i] != i) {
+				parent_[i] = parent_[parent_[i]];
+				i = parent_[i];
+			}
+			return i;
+		}
+		// 'i' and 'j' must be roots. 'j' becomes the root of the union.
+		void unite(int i, int j) { parent_[i] = j; }
+
+	private:
+		std::vector<int> parent_;
+	};
+
 }
 
 
@@ -110,6 +189,7 @@ void HypothesisGenerator::refine_planes() {
 	std::vector<VertexGroup::Ptr>& groups = pset_->groups();
 	const std::vector<vec3>& points = pset_->points();
 
+	StopWatch w;
 	std::size_t num = groups.size();
 
 	float avg_max_dist = 0;
@@ -133,46 +213,122 @@ void HypothesisGenerator::refine_planes() {
 
 	float theta = 10.0f;				// in degree
 	theta = static_cast<float>(M_PI * theta / 180.0f);	// in radian
-	bool merged = false;
-	do
-	{
-		merged = false;
-		std::sort(groups.begin(), groups.end(), VertexGroupCmpIncreasing());
-
-		for (std::size_t i = 0; i < groups.size(); ++i) {
-			VertexGroup* g1 = groups[i];
-			const Plane3d& plane1 = g1->plane();
-			const vec3& n1 = plane1.normal();
-			float num_threshold = g1->size() / 5.0f;
-			for (std::size_t j = i + 1; j < groups.size(); ++j) {
-				VertexGroup* g2 = groups[j];
-				const Plane3d& plane2 = g2->plane();
-				const vec3& n2 = plane2.normal();
-				if (std::abs(dot(n1, n2)) > std::cos(theta)) {
-					const std::list<unsigned int>& set1on2 = points_on_plane(g1, plane2, avg_max_dist);
-					const std::list<unsigned int>& set2on1 = points_on_plane(g2, plane1, avg_max_dist);
-					if (set1on2.size() > num_threshold || set2on1.size() > num_threshold) {
-						merge(g1, g2);
-						merged = true;
-						break;
-					}
+	const float cos_theta = std::cos(theta);
+
+	// Two segments are merged if their normals are within 'theta' and enough points of the smaller 
+	// one (i.e., the first in the increasing order of their sizes) lie on the plane of the other one
+	// or vice versa. The segments are processed in the increasing order of their sizes and each pair
+	// is tested once: when two segments are merged, only the pairs involving the new segment need to
+	// be tested. The result is the same as restarting the exhaustive pair scan after each merge.
+	std::vector<VertexGroup::Ptr> segments(groups.begin(), groups.end());	// indexed by the roots
+	std::vector<bool> processed(segments.size(), false);
+	SegmentUnion segment_union(segments.size());
+	NormalGrid grid(theta);
+	for (std::size_t i = 0; i < segments.size(); ++i)
+		grid.insert(static_cast<int>(i), segments[i]->plane().normal());
+
+	typedef std::pair<std::size_t, int> Order;	// (size, index): the order of processing
+	std::set<Order> queue;
+	for (std::size_t i = 0; i < segments.size(); ++i)
+		queue.insert(Order(segments[i]->size(), static_cast<int>(i)));
+
+	// collects (in increasing order) the segments whose normals are within 'theta' to that of 'id'
+	std::vector<int> neighbors;
+	std::vector<Order> candidates;
+	auto collect_candidates = [&](int id) {
+		candidates.clear();
+		const vec3& n = segments[id]->plane().normal();
+		grid.neighbors(n, neighbors);
+		for (std::size_t i = 0; i < neighbors.size(); ++i) {
+			int other = neighbors[i];
+			if (other != id && std::abs(dot(n, segments[other]->plane().normal())) > cos_theta)
+				candidates.push_back(Order(segments[other]->size(), other));
+		}
+		std::sort(candidates.begin(), candidates.end());
+	};
+
+	auto should_merge = [&](int first, int second) -> bool {
+		VertexGroup* g1 = segments[first];
+		VertexGroup* g2 = segments[second];
+		float num_threshold = g1->size() / 5.0f;
+		return enough_points_on_plane(g1, g2->plane(), avg_max_dist, num_threshold) ||
+			enough_points_on_plane(g2, g1->plane(), avg_max_dist, num_threshold);
+	};
+
+	// merges two segments and returns the root of the merged one
+	auto merge_segments = [&](int a, int b) -> int {
+		grid.remove(a, segments[a]->plane().normal());
+		grid.remove(b, segments[b]->plane().normal());
+		queue.erase(Order(segments[a]->size(), a));
+		queue.erase(Order(segments[b]->size(), b));
+
+		VertexGroup::Ptr g = merge(segments[a], segments[b]);
+		segment_union.unite(a, b);
+		segments[a] = nil;
+		segments[b] = g;
+		processed[b] = false;
+		grid.insert(b, g->plane().normal());
+		return b;
+	};
+
+	std::size_t num_tests = 0;
+	while (!queue.empty()) {
+		Order cur = *queue.begin();
+		queue.erase(queue.begin());
+		int id = cur.second;
+		processed[id] = true;
+
+		// test against the segments after it
+		collect_candidates(id);
+		int merged = -1;
+		for (std::size_t i = 0; i < candidates.size(); ++i) {
+			if (candidates[i] < cur)
+				continue;
+			++num_tests;
+			if (should_merge(id, candidates[i].second)) {
+				merged = merge_segments(id, candidates[i].second);
+				break;
+			}
+		}
+
+		// the segments before the merged one have already been processed, but they have not 
+		// been tested against the merged one yet.
+		while (merged >= 0) {
+			collect_candidates(merged);
+			int next = -1;
+			for (std::size_t i = 0; i < candidates.size(); ++i) {
+				int other = candidates[i].second;
+				if (!processed[other])
+					continue;
+				++num_tests;
+				if (should_merge(other, merged)) {
+					next = merge_segments(other, merged);
+					break;
 				}
 			}
-			if (merged)
-				break;
+			if (next < 0)
+				queue.insert(Order(segments[merged]->size(), merged));
+			merged = next;
 		}
-	} while (merged);
+	}
 
+	groups.clear();
+	for (std::size_t i = 0; i < segments.size(); ++i) {
+		if (segment_union.find(static_cast<int>(i)) == static_cast<int>(i))
+			groups.push_back(segments[i]);
+	}
 	std::sort(groups.begin(), groups.end(), VertexGroupCmpDecreasing());
 
 	if (num - groups.size() > 0) {
-		Logger::out("-") << num - groups.size() << " planar segments merged" << std::endl;
+		Logger::out("-") << num - groups.size() << " planar segments merged (" << num_tests << " pairs tested). "
+			<< w.elapsed() << " sec." << std::endl;
 	}
 }
 
 
 void HypothesisGenerator::collect_valid_planes() {
 	supporting_planes_.clear();
+	plane_index_.clear();
 	plane_segments_.clear();
 	vertex_group_plane_.clear();
 
@@ -183,7 +339,7 @@ void HypothesisGenerator::collect_valid_planes() {
 
 		plane_segments_.push_back(g);
 		Plane3d* plane = new Plane3d(g->plane());
-		supporting_planes_.push_back(plane);
+		add_supporting_plane(plane);
 		vertex_group_plane_[g] = plane;
 	}
 }
@@ -192,8 +348,8 @@ void HypothesisGenerator::collect_valid_planes() {
 
 static void check_source_planes(Map* mesh) {
 	MapFacetAttribute<Plane3d*>					face_supporting_plane(mesh, "FacetSupportingPlane");
-	MapHalfedgeAttribute< std::set<Plane3d*> >	edge_source_planes(mesh, "EdgeSourcePlanes");
-	MapVertexAttribute< std::set<Plane3d*> >	vertex_source_planes(mesh, "VertexSourcePlanes");
+	MapHalfedgeAttribute<EdgeSourcePlanes>	edge_source_planes(mesh, "EdgeSourcePlanes");
+	MapVertexAttribute<VertexSourcePlanes>	vertex_source_planes(mesh, "VertexSourcePlanes");
 
 	FOR_EACH_FACET(Map, mesh, it) {
 		if (face_supporting_plane[it] == nil)
@@ -201,29 +357,36 @@ static void check_source_planes(Map* mesh) {
 	}
 
 	FOR_EACH_HALFEDGE(Map, mesh, it) {
-		const std::set<Plane3d*>& tmp = edge_source_planes[it];
+		const EdgeSourcePlanes& tmp = edge_source_planes[it];
 		if (tmp.size() != 2)
 			std::cerr << "fatal error: edge_source_planes[it].size() != 2. Size = " << tmp.size() << std::endl;
 	}
 
 	FOR_EACH_VERTEX(Map, mesh, it) {
-		const std::set<Plane3d*>& tmp = vertex_source_planes[it];
+		const VertexSourcePlanes& tmp = vertex_source_planes[it];
 		if (tmp.size() != 3)
 			std::cerr << "vertex_source_planes[it].size() != 3. Size = " << tmp.size() << std::endl;
 	}
 }
 
 
-Map* HypothesisGenerator::construct_bbox_mesh() {
-	Box3d box = pset_->bbox();
-    float delta = box.radius() * 0.05f;
-
+Map* HypothesisGenerator::construct_bbox_mesh(const Box3d& box, float delta, const std::vector<Plane3d*>& planes) {
 	Map* mesh = new Map;
 	MapBuilder builder(mesh);
 
 	MapFacetAttribute<Plane3d*> face_supporting_plane(mesh, "FacetSupportingPlane");
-	MapHalfedgeAttribute< std::set<Plane3d*> >	edge_source_planes(mesh, "EdgeSourcePlanes");
-	MapVertexAttribute< std::set<Plane3d*> >	vertex_source_planes(mesh, "VertexSourcePlanes");
+	MapHalfedgeAttribute<EdgeSourcePlanes>	edge_source_planes(mesh, "EdgeSourcePlanes");
+	MapVertexAttribute<VertexSourcePlanes>	vertex_source_planes(mesh, "VertexSourcePlanes");
+
+	// the plane of each face of the box, which is appended to the supporting planes unless it is given
+	std::size_t num_faces = 0;
+	auto face_plane = [&](MapTypes::Facet* f) -> Plane3d* {
+		if (planes.size() == 6)
+			return planes[num_faces++];
+		Plane3d* plane = new Plane3d(Geom::facet_plane(f));
+		add_supporting_plane(plane);
+		return plane;
+	};
 
 	float xmin = box.x_min() - delta, xmax = box.x_max() + delta;
 	float ymin = box.y_min() - delta, ymax = box.y_max() + delta;
@@ -248,9 +411,7 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 	builder.add_vertex_to_facet(3);
 	builder.end_facet();
 	MapTypes::Facet* f = builder.current_facet();
-	Plane3d* plane = new Plane3d(Geom::facet_plane(f));
-	supporting_planes_.push_back(plane);
-	face_supporting_plane[f] = plane;
+	face_supporting_plane[f] = face_plane(f);
 
 	builder.begin_facet();
 	builder.add_vertex_to_facet(1);
@@ -259,9 +420,7 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 	builder.add_vertex_to_facet(2);
 	builder.end_facet();
 	f = builder.current_facet();
-	plane = new Plane3d(Geom::facet_plane(f));
-	supporting_planes_.push_back(plane);
-	face_supporting_plane[f] = plane;
+	face_supporting_plane[f] = face_plane(f);
 
 	builder.begin_facet();
 	builder.add_vertex_to_facet(1);
@@ -270,9 +429,7 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 	builder.add_vertex_to_facet(5);
 	builder.end_facet();
 	f = builder.current_facet();
-	plane = new Plane3d(Geom::facet_plane(f));
-	supporting_planes_.push_back(plane);
-	face_supporting_plane[f] = plane;
+	face_supporting_plane[f] = face_plane(f);
 
 	builder.begin_facet();
 	builder.add_vertex_to_facet(4);
@@ -281,9 +438,7 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 	builder.add_vertex_to_facet(7);
 	builder.end_facet();
 	f = builder.current_facet();
-	plane = new Plane3d(Geom::facet_plane(f));
-	supporting_planes_.push_back(plane);
-	face_supporting_plane[f] = plane;
+	face_supporting_plane[f] = face_plane(f);
 
 	builder.begin_facet();
 	builder.add_vertex_to_facet(0);
@@ -292,9 +447,7 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 	builder.add_vertex_to_facet(6);
 	builder.end_facet();
 	f = builder.current_facet();
-	plane = new Plane3d(Geom::facet_plane(f));
-	supporting_planes_.push_back(plane);
-	face_supporting_plane[f] = plane;
+	face_supporting_plane[f] = face_plane(f);
 
 	builder.begin_facet();
 	builder.add_vertex_to_facet(2);
@@ -303,9 +456,7 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 	builder.add_vertex_to_facet(3);
 	builder.end_facet();
 	f = builder.current_facet();
-	plane = new Plane3d(Geom::facet_plane(f));
-	supporting_planes_.push_back(plane);
-	face_supporting_plane[f] = plane;
+	face_supporting_plane[f] = face_plane(f);
 
 	builder.end_surface();
 
@@ -313,8 +464,8 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 	FOR_EACH_HALFEDGE(Map, mesh, it) {
 		Plane3d* plane1 = face_supporting_plane[it->facet()];
 		Plane3d* plane2 = face_supporting_plane[it->opposite()->facet()];
-		edge_source_planes[it].insert(plane1);
-		edge_source_planes[it].insert(plane2);
+		edge_source_planes[it].insert(plane_id(plane1));
+		edge_source_planes[it].insert(plane_id(plane2));
 	}
 
 	// assign the original planes for each vertex
@@ -322,7 +473,7 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 		VertexInHalfedgeCirculator cit(it);
 		for (; !cit->end(); ++cit) {
 			Plane3d* plane = face_supporting_plane[cit->facet()];
-			vertex_source_planes[it].insert(plane);
+			vertex_source_planes[it].insert(plane_id(plane));
 		}
 		if (cit->size() != 3)
 			Logger::err("-") << "fatal_error. A bbox mesh corner does not relate to 3 planes" << std::endl;
@@ -332,28 +483,24 @@ Map* HypothesisGenerator::construct_bbox_mesh() {
 }
 
 
-Map* HypothesisGenerator::compute_proxy_mesh(Map* bbox_mesh) {
+void HypothesisGenerator::add_proxy_faces(Map* bbox_mesh, const std::vector<VertexGroup*>& segments, MapBuilder& builder, int& idx) {
 	MapFacetAttribute<Plane3d*>					bbox_mesh_face_supporting_plane(bbox_mesh, "FacetSupportingPlane");
-	MapHalfedgeAttribute< std::set<Plane3d*> >	bbox_mesh_edge_source_planes(bbox_mesh, "EdgeSourcePlanes");
-	MapVertexAttribute< std::set<Plane3d*> >	bbox_mesh_vertex_source_planes(bbox_mesh, "VertexSourcePlanes");
-
-	Map* mesh = new Map;
-	MapBuilder builder(mesh);
+	MapHalfedgeAttribute<EdgeSourcePlanes>	bbox_mesh_edge_source_planes(bbox_mesh, "EdgeSourcePlanes");
+	MapVertexAttribute<VertexSourcePlanes>	bbox_mesh_vertex_source_planes(bbox_mesh, "VertexSourcePlanes");
 
+	Map* mesh = builder.target();
 	MapFacetAttribute<Color> color(mesh, "color");
 	MapFacetAttribute<VertexGroup*> facet_supporting_vertex_group(mesh, Method::facet_attrib_supporting_vertex_group);
 	MapFacetAttribute<Plane3d*>		face_supporting_plane(mesh, "FacetSupportingPlane");
-	MapHalfedgeAttribute< std::set<Plane3d*> >	edge_source_planes(mesh, "EdgeSourcePlanes");
-	MapVertexAttribute< std::set<Plane3d*> >	vertex_source_planes(mesh, "VertexSourcePlanes");
+	MapHalfedgeAttribute<EdgeSourcePlanes>	edge_source_planes(mesh, "EdgeSourcePlanes");
+	MapVertexAttribute<VertexSourcePlanes>	vertex_source_planes(mesh, "VertexSourcePlanes");
 
-	builder.begin_surface();
-	int idx = 0;
-	for (std::size_t i = 0; i < plane_segments_.size(); ++i) {
-		VertexGroup* g = plane_segments_[i];
+	for (std::size_t i = 0; i < segments.size(); ++i) {
+		VertexGroup* g = segments[i];
 		Plane3d* plane = vertex_group_plane_[g];
 
 		std::vector<vec3> points;
-		std::vector< std::set<Plane3d*> > point_source_planes;
+		std::vector<VertexSourcePlanes> point_source_planes;
 		FOR_EACH_EDGE_CONST(Map, bbox_mesh, it) {
 			const vec3& s = it->prev()->vertex()->point();
 			const vec3& t = it->vertex()->point();
@@ -364,8 +511,8 @@ Map* HypothesisGenerator::compute_proxy_mesh(Map* bbox_mesh) {
 				if (plane->intersection(Line3d::from_two_points(s, t), p)) {
 					points.push_back(p);
 
-					std::set<Plane3d*> planes = bbox_mesh_edge_source_planes[it];
-					planes.insert(plane);
+					VertexSourcePlanes planes(bbox_mesh_edge_source_planes[it]);
+					planes.insert(plane_id(plane));
 					point_source_planes.push_back(planes);
 				}
 				else
@@ -375,13 +522,13 @@ Map* HypothesisGenerator::compute_proxy_mesh(Map* bbox_mesh) {
 				if (ss == ZERO) {
 					points.push_back(s);
 
-					std::set<Plane3d*> planes = bbox_mesh_vertex_source_planes[it->prev()->vertex()];
+					const VertexSourcePlanes& planes = bbox_mesh_vertex_source_planes[it->prev()->vertex()];
 					point_source_planes.push_back(planes);
 				}
 				else if (st == ZERO) {
 					points.push_back(t);
 
-					std::set<Plane3d*> planes = bbox_mesh_vertex_source_planes[it->vertex()];
+					const VertexSourcePlanes& planes = bbox_mesh_vertex_source_planes[it->vertex()];
 					point_source_planes.push_back(planes);
 				}
 				else {
@@ -404,7 +551,7 @@ Map* HypothesisGenerator::compute_proxy_mesh(Map* bbox_mesh) {
 			CGAL::convex_hull_2(pts.begin(), pts.end(), std::back_inserter(hull), Projection());
 
 			std::vector<vec3> ch;
-			std::vector< std::set<Plane3d*> > ch_source_planes;
+			std::vector<VertexSourcePlanes> ch_source_planes;
 
 			for (std::list<Point3>::iterator it = hull.begin(); it != hull.end(); ++it) {
 				int idx = int(it->z());
@@ -433,16 +580,16 @@ Map* HypothesisGenerator::compute_proxy_mesh(Map* bbox_mesh) {
 					FacetHalfedgeCirculator cir(f);
 					for (; !cir->end(); ++cir) {
 						MapTypes::Halfedge* h = cir->halfedge();
-						edge_source_planes[h].insert(plane);
+						edge_source_planes[h].insert(plane_id(plane));
 
 						FOR_EACH_FACET(Map, bbox_mesh, fc) {
 							Plane3d* bbox_plane = bbox_mesh_face_supporting_plane[fc];
 							if ((bbox_plane->squared_ditance(h->vertex()->point()) < 1e-6) && (bbox_plane->squared_ditance(h->prev()->vertex()->point()) < 1e-6)) {
-								edge_source_planes[h].insert(bbox_plane);
+								edge_source_planes[h].insert(plane_id(bbox_plane));
 								break;
 							}
 						}
-						std::set<Plane3d*> tmp = edge_source_planes[h];
+						const EdgeSourcePlanes& tmp = edge_source_planes[h];
 						if (tmp.size() != 2) {
 							Logger::err("-") << "fatal error: edge_source_planes[h].size() != 2. Size = " << tmp.size() << std::endl;
 						}
@@ -465,21 +612,52 @@ Map* HypothesisGenerator::compute_proxy_mesh(Map* bbox_mesh) {
 		}
 	}
 
-	builder.end_surface();
+	check_source_planes(bbox_mesh);
+}
+
 
+// the border halfedges get the source planes of their opposite halfedges
+static void complete_proxy_source_planes(Map* mesh) {
+	MapHalfedgeAttribute<EdgeSourcePlanes>	edge_source_planes(mesh, "EdgeSourcePlanes");
 	FOR_EACH_HALFEDGE(Map, mesh, it) {
-		const std::set<Plane3d*>& tmp = edge_source_planes[it];
+		const EdgeSourcePlanes& tmp = edge_source_planes[it];
 		if (tmp.size() == 2 && edge_source_planes[it->opposite()].size() != 2)
 			edge_source_planes[it->opposite()] = tmp;
 	}
+	edge_source_planes.unbind();
 
-	check_source_planes(bbox_mesh);
 	check_source_planes(mesh);
+}
+
+
+Map* HypothesisGenerator::compute_proxy_mesh(Map* bbox_mesh) {
+	Map* mesh = new Map;
+	MapBuilder builder(mesh);
+	builder.begin_surface();
+	int idx = 0;
+	std::vector<VertexGroup*> segments(plane_segments_.begin(), plane_segments_.end());
+	add_proxy_faces(bbox_mesh, segments, builder, idx);
+	builder.end_surface();
 
+	complete_proxy_source_planes(mesh);
 	return mesh;
 }
 
 
+namespace {
+
+	// the union-find of the cells
+	int find_root(std::vector<int>& parent, int i) {
+		while (parent[i] != i) {
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+
+}
+
+
 static bool halfedge_exists_between_vertices(Map::Vertex* v1, Map::Vertex* v2) {
 	Map::Halfedge* cir = v1->halfedge();
 	do {
@@ -493,23 +671,32 @@ static bool halfedge_exists_between_vertices(Map::Vertex* v1, Map::Vertex* v2) {
 
 
 // test if face f and plane intersect
-bool HypothesisGenerator::do_intersect(MapTypes::Facet* f, Plane3d* plane)
+bool HypothesisGenerator::do_intersect(MapTypes::Facet* f, Plane3d* plane, CutAttributes& attribs)
 {
     std::vector<Intersection> vts;
-    compute_intersections(f, plane, vts);
+    compute_intersections(f, plane, vts, attribs);
 
     return (vts.size() > 1);
 }
 
 
-std::set<Plane3d *> HypothesisGenerator::collect_cutting_planes(MapTypes::Facet *face, Map *mesh) {
+std::set<Plane3d *> HypothesisGenerator::collect_cutting_planes(
+	MapTypes::Facet* face,
+	const std::vector<MapTypes::Facet*>& faces,
+	const FacetBoxTree& tree,
+	CutAttributes& attribs)
+{
 	std::set<Plane3d*> cutting_planes;
-	FOR_EACH_FACET(Map, mesh, it) {
-		Map::Facet* f = it;
+	Plane3d* face_plane = attribs.supporting_plane[face];
+
+	std::vector<std::size_t> candidates;
+	tree.facets_intersecting(*face_plane, candidates);
+	for (std::size_t i = 0; i < candidates.size(); ++i) {
+		Map::Facet* f = faces[candidates[i]];
 		if (f != face) {
-		    Plane3d* plane = facet_attrib_supporting_plane_[f];
-		    if (plane != facet_attrib_supporting_plane_[face]) {
-			    if (do_intersect(f, facet_attrib_supporting_plane_[face]))
+		    Plane3d* plane = attribs.supporting_plane[f];
+		    if (plane != face_plane) {
+			    if (do_intersect(f, face_plane, attribs))
                     cutting_planes.insert(plane);
 			}
 		}
@@ -521,7 +708,8 @@ std::set<Plane3d *> HypothesisGenerator::collect_cutting_planes(MapTypes::Facet
 void HypothesisGenerator::compute_intersections(
         MapTypes::Facet* f,
         Plane3d* plane,
-        std::vector<Intersection>& vts)
+        std::vector<Intersection>& vts,
+        CutAttributes& attribs)
 {
     vts.clear();
 
@@ -535,35 +723,27 @@ void HypothesisGenerator::compute_intersections(
             vts.push_back(it);
         }
         else if (plane->squared_ditance(s) > Method::snap_sqr_distance_threshold) {	// cut at the edge
-            const std::set<Plane3d*>& source_planes = edge_source_planes_[h];
+            const EdgeSourcePlanes& source_planes = attribs.edge_source_planes[h];
             if (source_planes.size() == 2) {  // if the edge was computed from two faces, I use the source faces for computing the intersecting point
                 if (plane->intersection(s, t)) {
-                    Plane3d* plane1 = *(source_planes.begin());
-                    Plane3d* plane2 = *(source_planes.rbegin());
+                    Plane3d* plane1 = supporting_planes_[source_planes[0]];
+                    Plane3d* plane2 = supporting_planes_[source_planes[1]];
                     Plane3d* plane3 = plane;
                     if (plane3 != plane1 && plane3 != plane2) {
-                        vec3* p = query_intersection(plane1, plane2, plane3);
-                        if (p) {
+                        vec3 p;
+                        // the table computes each triplet once (from the planes in the order of their ids), 
+                        // so a miss (degenerate, or outside the box) is not computed again
+                        if (query_intersection(source_planes[0], source_planes[1], plane_id(plane3), p, attribs.triplets)) {
                             Intersection it(Intersection::NEW_VERTEX);
                             it.edge = h;
-                            it.pos = *p;
+                            it.pos = p;
                             vts.push_back(it);
                         }
-                        else {
-                            vec3 q;
-                            if (intersection_plane_triplet(plane1, plane2, plane3, q)) {
-                                triplet_intersection_[plane1][plane2][plane3] = p; // store the intersection in our data base
-                                Intersection it(Intersection::NEW_VERTEX);
-                                it.edge = h;
-                                it.pos = q;
-                                vts.push_back(it);
-                            }
-                            else
-                                Logger::warn("-") << "fatal error. should have intersection. " << std::endl;
-                        }
+                        else
+                            warn(attribs.triplets, "fatal error. should have intersection.");
                     }
                     else {
-                        Logger::warn("-") << "fatal error. should have 3 different planes. " << std::endl;
+                        warn(attribs.triplets, "fatal error. should have 3 different planes.");
                     }
                 }
             }
@@ -583,8 +763,8 @@ void HypothesisGenerator::compute_intersections(
 
 
 // split an existing edge, meanwhile, assign the new edges the original source faces (the old edge lies in the intersection of the two faces)
-MapTypes::Vertex* HypothesisGenerator::split_edge(const Intersection& ep, MapEditor* editor, Plane3d* cutter) {
-	const std::set<Plane3d*>& sfs = edge_source_planes_[ep.edge];
+MapTypes::Vertex* HypothesisGenerator::split_edge(const Intersection& ep, MapEditor* editor, Plane3d* cutter, CutAttributes& attribs) {
+	const EdgeSourcePlanes sfs = attribs.edge_source_planes[ep.edge];
 	assert(sfs.size() == 2);
 
     MapTypes::Vertex* v = editor->split_edge(ep.edge);
@@ -592,29 +772,29 @@ MapTypes::Vertex* HypothesisGenerator::split_edge(const Intersection& ep, MapEdi
 
     if (sfs.size() == 2) {
         MapTypes::Halfedge* h = v->halfedge();
-        edge_source_planes_[h] = sfs;
-        edge_source_planes_[h->opposite()] = sfs;
+        attribs.edge_source_planes[h] = sfs;
+        attribs.edge_source_planes[h->opposite()] = sfs;
 
         h = h->next();
-        edge_source_planes_[h] = sfs;
-        edge_source_planes_[h->opposite()] = sfs;
+        attribs.edge_source_planes[h] = sfs;
+        attribs.edge_source_planes[h->opposite()] = sfs;
     }
     else {
-        Logger::warn("-") << "edge_source_planes.size != 2" << std::endl;
+        warn(attribs.triplets, "edge_source_planes.size != 2");
     }
 
-    vertex_source_planes_[v] = sfs;
-    vertex_source_planes_[v].insert(cutter);
+    attribs.vertex_source_planes[v] = VertexSourcePlanes(sfs);
+    attribs.vertex_source_planes[v].insert(plane_id(cutter));
 
     return v;
 }
 
 
-std::vector<Map::Facet*> HypothesisGenerator::cut(MapTypes::Facet* f, Plane3d* cutter, Map* mesh) {
+std::vector<Map::Facet*> HypothesisGenerator::cut(MapTypes::Facet* f, Plane3d* cutter, Map* mesh, CutAttributes& attribs) {
 	std::vector<Map::Facet*> new_faces;
 
     std::vector<Intersection> vts;
-    compute_intersections(f, cutter, vts);
+    compute_intersections(f, cutter, vts, attribs);
     if (vts.size() < 2) // no actual intersection
         return new_faces;
     else if (vts.size() >= 3) {
@@ -680,16 +860,16 @@ std::vector<Map::Facet*> HypothesisGenerator::cut(MapTypes::Facet* f, Plane3d* c
 		// test if the two intersecting points are both very close to an existing vertex.
 		// Since we allow snapping, we test if the two intersecting points are the same.
 		if (vts[0].type == Intersection::NEW_VERTEX && vts[1].type == Intersection::NEW_VERTEX) {
-            v0 = split_edge(vts[0], &editor, cutter);
-            v1 = split_edge(vts[1], &editor, cutter);
+            v0 = split_edge(vts[0], &editor, cutter, attribs);
+            v1 = split_edge(vts[1], &editor, cutter, attribs);
         }
         else if (vts[0].type == Intersection::NEW_VERTEX && vts[1].type == Intersection::EXISTING_VERTEX) {
-            v0 = split_edge(vts[0], &editor, cutter);
+            v0 = split_edge(vts[0], &editor, cutter, attribs);
             v1 = vts[1].vtx;
         }
         else if (vts[0].type == Intersection::EXISTING_VERTEX && vts[1].type == Intersection::NEW_VERTEX) {
             v0 = vts[0].vtx;
-            v1 = split_edge(vts[1], &editor, cutter);
+            v1 = split_edge(vts[1], &editor, cutter, attribs);
         }
         else if (vts[0].type == Intersection::EXISTING_VERTEX && vts[1].type == Intersection::EXISTING_VERTEX) {
             if (halfedge_exists_between_vertices(vts[0].vtx, vts[1].vtx))
@@ -701,7 +881,7 @@ std::vector<Map::Facet*> HypothesisGenerator::cut(MapTypes::Facet* f, Plane3d* c
         }
 	}
 	else
-        Logger::warn("-") << "This might be an error: number of intersecting points is " << vts.size() << std::endl;
+        warn(attribs.triplets, "This might be an error: number of intersecting points is " + std::to_string(vts.size()));
 
 	//////////////////////////////////////////////////////////////////////////
 
@@ -725,315 +905,2007 @@ std::vector<Map::Facet*> HypothesisGenerator::cut(MapTypes::Facet* f, Plane3d* c
 	}
 	assert(h1->facet() == f);
 
-    VertexGroup* g = facet_attrib_supporting_vertex_group_[f];
+    VertexGroup* g = attribs.supporting_vertex_group[f];
 	if (editor.can_split_facet(h0, h1)) {
 		Map::Halfedge* h = editor.split_facet(h0, h1);
 		if (h) {
-			edge_source_planes_[h].insert(facet_attrib_supporting_plane_[f]);
-			edge_source_planes_[h].insert(cutter);
-			edge_source_planes_[h->opposite()].insert(facet_attrib_supporting_plane_[f]);
-			edge_source_planes_[h->opposite()].insert(cutter);
+			EdgeSourcePlanes planes;
+			planes.insert(plane_id(attribs.supporting_plane[f]));
+			planes.insert(plane_id(cutter));
+			attribs.edge_source_planes[h] = planes;
+			attribs.edge_source_planes[h->opposite()] = planes;
 
 			Map::Facet* f1 = h->facet();
-			facet_attrib_supporting_vertex_group_[f1] = g;
+			attribs.supporting_vertex_group[f1] = g;
 			new_faces.push_back(f1);
 			Map::Facet* f2 = h->opposite()->facet();
-			facet_attrib_supporting_vertex_group_[f2] = g;
+			attribs.supporting_vertex_group[f2] = g;
 			new_faces.push_back(f2);
 		}
 		else
-			Logger::warn("-") << "fatal error. should have intersection." << std::endl;
+			warn(attribs.triplets, "fatal error. should have intersection.");
 	}
 
 	return new_faces;
 }
 
 
-void HypothesisGenerator::pairwise_cut(Map* mesh)
-{
-	std::vector<MapTypes::Facet*> all_faces;
-	FOR_EACH_FACET(Map, mesh, it) {
-		MapTypes::Facet* f = it;
-		all_faces.push_back(f);
-	}
+int HypothesisGenerator::resolved_num_threads() const {
+	if (num_threads_ > 0)
+		return num_threads_;
+	return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
 
-	std::map< MapTypes::Facet*, std::set<Plane3d *> > face_cutters;
-    for (std::size_t i = 0; i < all_faces.size(); ++i) {
-        MapTypes::Facet *f = all_faces[i];
-        face_cutters[f] = collect_cutting_planes(f, mesh);
-    }
 
-	ProgressLogger progress(all_faces.size());
-	for (std::size_t i = 0; i < all_faces.size(); ++i) {
-		MapTypes::Facet* f = all_faces[i];
+void HypothesisGenerator::CutAttributes::bind(Map* mesh) {
+	supporting_vertex_group.bind(mesh, Method::facet_attrib_supporting_vertex_group);
+	supporting_plane.bind(mesh, "FacetSupportingPlane");
+	edge_source_planes.bind(mesh, "EdgeSourcePlanes");
+	vertex_source_planes.bind(mesh, "VertexSourcePlanes");
+}
 
-		std::set<Plane3d*>& cutting_planes = face_cutters[f];
-		if (cutting_planes.empty())
-			continue;
 
-		// f will be cut by all the intersecting_faces
-		// note: after each cut, the original face doesn't exist any more and it is replaced by multiple pieces.
-		//       then each piece will be cut by another face.
-		std::vector<MapTypes::Facet*> faces_to_be_cut;
-		faces_to_be_cut.push_back(f);
-		while (!cutting_planes.empty()) {
-			std::set<MapTypes::Facet*> new_faces;		// stores the new faces
-			std::set<MapTypes::Facet*> remained_faces;	// faces that will be cut later
-            Plane3d* cutter = *(cutting_planes.begin());
-			for (std::size_t j = 0; j < faces_to_be_cut.size(); ++j) {
-				MapTypes::Facet* current_face = faces_to_be_cut[j];
-				std::vector<MapTypes::Facet*> tmp = cut(current_face, cutter, mesh);
-				new_faces.insert(tmp.begin(), tmp.end());
-				if (tmp.empty()) {
-					remained_faces.insert(current_face);
-				}
+void HypothesisGenerator::CutAttributes::unbind() {
+	supporting_vertex_group.unbind();
+	supporting_plane.unbind();
+	edge_source_planes.unbind();
+	vertex_source_planes.unbind();
+}
+
+
+void HypothesisGenerator::cut_face(MapTypes::Facet* f, std::set<Plane3d*>& cutting_planes, Map* mesh, CutAttributes& attribs) {
+	// f will be cut by all the intersecting_faces
+	// note: after each cut, the original face doesn't exist any more and it is replaced by multiple pieces.
+	//       then each piece will be cut by another face.
+	// NOTE: the pieces are kept in the order they are created (not in the order of their addresses), so
+	//       the result doesn't depend on the memory layout of the mesh (see piecewise_cut()).
+	std::vector<MapTypes::Facet*> faces_to_be_cut;
+	faces_to_be_cut.push_back(f);
+	while (!cutting_planes.empty()) {
+		std::vector<MapTypes::Facet*> new_faces;		// stores the new faces
+		std::vector<MapTypes::Facet*> remained_faces;	// faces that will be cut later
+		Plane3d* cutter = *(cutting_planes.begin());
+		for (std::size_t j = 0; j < faces_to_be_cut.size(); ++j) {
+			MapTypes::Facet* current_face = faces_to_be_cut[j];
+			std::vector<MapTypes::Facet*> tmp = cut(current_face, cutter, mesh, attribs);
+			new_faces.insert(new_faces.end(), tmp.begin(), tmp.end());
+			if (tmp.empty()) {
+				remained_faces.push_back(current_face);
 			}
-			faces_to_be_cut = std::vector<MapTypes::Facet*>(new_faces.begin(), new_faces.end());
-			faces_to_be_cut.insert(faces_to_be_cut.end(), remained_faces.begin(), remained_faces.end());
-            cutting_planes.erase(cutter);
 		}
-
-		progress.next();
+		faces_to_be_cut.swap(new_faces);
+		faces_to_be_cut.insert(faces_to_be_cut.end(), remained_faces.begin(), remained_faces.end());
+		cutting_planes.erase(cutter);
 	}
 }
 
 
-// compute the intersection of a plane triplet
-// returns true if the intersection exists (p returns the point)
-bool HypothesisGenerator::intersection_plane_triplet(const Plane3d* plane1, const Plane3d* plane2, const Plane3d* plane3, vec3& p) {
-	if (plane1 == nil || plane2 == nil || plane3 == nil) {
-		Logger::err("-") << "null planes" << std::endl;
-		return false;
-	}
-	if (plane1 == plane2 || plane2 == plane3) {
-		Logger::err("-") << "identical planes" << std::endl;
-		return false;
+void HypothesisGenerator::collect_all_cutting_planes(
+	Map* mesh,
+	CutAttributes& attribs,
+	std::vector<MapTypes::Facet*>& faces,
+	std::vector< std::set<Plane3d*> >& cutting_planes
+)
+{
+	faces.clear();
+	FOR_EACH_FACET(Map, mesh, it) {
+		MapTypes::Facet* f = it;
+		faces.push_back(f);
 	}
 
-	CGAL::Object obj = CGAL::intersection(to_cgal_plane(*plane1), to_cgal_plane(*plane2), to_cgal_plane(*plane3));
+	// the boxes are padded by the snapping distance (and a tiny fraction of the scene size for 
+	// the floating point errors), so that the tree never rejects a face that actually intersects.
+	float padding = static_cast<float>(std::sqrt(Method::snap_sqr_distance_threshold)) + mesh->bbox().radius() * 1e-6f;
+	FacetBoxTree tree(faces, padding);
 
-	// pt is the intersection point of the 3 planes 
-	if (const Point3* pt = CGAL::object_cast<Point3>(&obj)) {
-		p = to_my_point(*pt);
-		return true;
-	}
-	else if (const Plane3* plane = CGAL::object_cast<Plane3>(&obj)) {
-		Logger::warn("-") << "3 faces lie on the same supporting plane" << std::endl;
-		return false;
-	}
-	else if (const Line3* line = CGAL::object_cast<Line3>(&obj)) {
-		Logger::warn("-") << "3 faces intersect at the same line" << std::endl;
-		return false;
+	cutting_planes.assign(faces.size(), std::set<Plane3d*>());
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		MapTypes::Facet *f = faces[i];
+		cutting_planes[i] = collect_cutting_planes(f, faces, tree, attribs);
 	}
-
-	return false;
 }
 
 
-void HypothesisGenerator::triplet_intersection() {
-	triplet_intersection_.clear();
+void HypothesisGenerator::pairwise_cut(Map* mesh, CutAttributes& attribs)
+{
+	std::vector<MapTypes::Facet*> all_faces;
+	std::vector< std::set<Plane3d *> > face_cutters;
+	collect_all_cutting_planes(mesh, attribs, all_faces, face_cutters);
+	cut_proxy_faces(mesh, attribs, all_faces, face_cutters);
+}
 
-	std::sort(supporting_planes_.begin(), supporting_planes_.end());
 
-	for (std::size_t i = 0; i < supporting_planes_.size(); ++i) {
-		Plane3d* plane1 = supporting_planes_[i];
-		for (std::size_t j = i + 1; j < supporting_planes_.size(); ++j) {
-			Plane3d* plane2 = supporting_planes_[j];
-			for (std::size_t k = j + 1; k < supporting_planes_.size(); ++k) {
-				Plane3d* plane3 = supporting_planes_[k];
+void HypothesisGenerator::cut_proxy_faces(
+	Map* mesh,
+	CutAttributes& attribs,
+	const std::vector<MapTypes::Facet*>& faces,
+	std::vector< std::set<Plane3d*> >& cutting_planes
+)
+{
+	int num_threads = resolved_num_threads();
+	if (cutting_method_ == LINE_ARRANGEMENT) {
+		arrangement_pairwise_cut(mesh, attribs, faces, cutting_planes, num_threads);
+		return;
+	}
+	piecewise_cut(mesh, attribs, faces, cutting_planes, num_threads);
+}
 
-				assert(plane1 < plane2);
-				assert(plane2 < plane3);
 
-				vec3 p;
-				if (intersection_plane_triplet(plane1, plane2, plane3, p)) {
-					vec3* new_point = new vec3(p);
-					triplet_intersection_[plane1][plane2][plane3] = new_point; // store the intersection in our data base
-					intersecting_points_.push_back(new_point);
-				}
+// Appends 'facets' (and their vertices) of mesh 'from' to the surface being built by 'builder', together
+// with the attributes required by the cutting. The source planes of the border halfedges do not exist
+// yet and they are completed by complete_border_source_planes() after end_surface().
+static void append_facets(
+	const std::vector<Map::Facet*>& facets,
+	Map* from,
+	MapBuilder& builder,
+	int& cur_vertex_id
+)
+{
+	MapFacetAttribute<Color>					from_color(from, "color");
+	MapFacetAttribute<VertexGroup*>				from_group(from, Method::facet_attrib_supporting_vertex_group);
+	MapFacetAttribute<Plane3d*>					from_plane(from, "FacetSupportingPlane");
+	MapHalfedgeAttribute<EdgeSourcePlanes>		from_edge_planes(from, "EdgeSourcePlanes");
+	MapVertexAttribute<VertexSourcePlanes>		from_vertex_planes(from, "VertexSourcePlanes");
+
+	Map* to = builder.target();
+	MapFacetAttribute<Color>					to_color(to, "color");
+	MapFacetAttribute<VertexGroup*>				to_group(to, Method::facet_attrib_supporting_vertex_group);
+	MapFacetAttribute<Plane3d*>					to_plane(to, "FacetSupportingPlane");
+	MapHalfedgeAttribute<EdgeSourcePlanes>		to_edge_planes(to, "EdgeSourcePlanes");
+	MapVertexAttribute<VertexSourcePlanes>		to_vertex_planes(to, "VertexSourcePlanes");
+
+	std::map<Map::Vertex*, int>			vertex_id;
+	std::map<Map::Vertex*, Map::Vertex*>	vertex_copy;
+	for (std::size_t i = 0; i < facets.size(); ++i) {
+		Map::Facet* f = facets[i];
+		FacetHalfedgeCirculator cir(f);
+		for (; !cir->end(); ++cir) {
+			Map::Vertex* v = cir->halfedge()->vertex();
+			if (vertex_id.find(v) == vertex_id.end()) {
+				vertex_id[v] = cur_vertex_id++;
+				builder.add_vertex(v->point());
+				vertex_copy[v] = builder.current_vertex();
+				to_vertex_planes[builder.current_vertex()] = from_vertex_planes[v];
 			}
 		}
 	}
-}
 
+	for (std::size_t i = 0; i < facets.size(); ++i) {
+		Map::Facet* f = facets[i];
+		std::map<Map::Vertex*, Map::Halfedge*> halfedge_to;	// the halfedge of 'f' pointing to each copied vertex
+		builder.begin_facet();
+		FacetHalfedgeCirculator cir(f);
+		for (; !cir->end(); ++cir) {
+			Map::Halfedge* h = cir->halfedge();
+			builder.add_vertex_to_facet(vertex_id[h->vertex()]);
+			halfedge_to[vertex_copy[h->vertex()]] = h;
+		}
+		builder.end_facet();
 
-void HypothesisGenerator::remove_degenerated_facets(Map* mesh) {
-	// You can't collect all the edges and then collapse them one by one, 
-	// because collapsing one edge affects other neighboring edges.
-	// std::vector<Map::Halfedge*> to_collapse;
+		Map::Facet* g = builder.current_facet();
+		to_color[g] = from_color[f];
+		to_group[g] = from_group[f];
+		to_plane[g] = from_plane[f];
 
-	MapEditor editor(mesh);
-	bool degenerated_facet_found = false;
-	int count = 0;
-	do {
-		degenerated_facet_found = false;
-		FOR_EACH_EDGE(Map, mesh, it) {
-			double sd = distance2(it->vertex()->point(), it->prev()->vertex()->point());
-			if (sd < Method::snap_sqr_distance_threshold) {
-				degenerated_facet_found = true;
-				if (editor.collapse_edge(it)) {
-					++count;
-					break;  // Liangliang: only one edge can be collapsed (one may affect others)
-				}
-			}
+		FacetHalfedgeCirculator git(g);
+		for (; !git->end(); ++git) {
+			Map::Halfedge* h = git->halfedge();
+			to_edge_planes[h] = from_edge_planes[halfedge_to[h->vertex()]];
 		}
-	} while (degenerated_facet_found);
+	}
+}
+
 
-	if (count > 0)
-		Logger::out("-") << count << " degenerate edges collapsed" << std::endl;
+// the border halfedges get the source planes of their opposite ones
+static void complete_border_source_planes(Map* mesh) {
+	MapHalfedgeAttribute<EdgeSourcePlanes> edge_source_planes(mesh, "EdgeSourcePlanes");
+	FOR_EACH_HALFEDGE(Map, mesh, it) {
+		if (it->is_border())
+			edge_source_planes[it] = edge_source_planes[it->opposite()];
+	}
 }
 
 
-vec3* HypothesisGenerator::query_intersection(Plane3d* plane1, Plane3d* plane2, Plane3d* plane3) {
-	Plane3d* min_plane = ogf_min(plane1, plane2, plane3);
-	Plane3d* max_plane = ogf_max(plane1, plane2, plane3);
+// The builder splits the non-manifold vertices (e.g., two cells of a plane touching at a single point)
+// and the copies have no source planes. Those are given by the two edges of the vertex.
+static void complete_split_vertex_source_planes(Map* mesh) {
+	MapHalfedgeAttribute<EdgeSourcePlanes> edge_source_planes(mesh, "EdgeSourcePlanes");
+	MapVertexAttribute<VertexSourcePlanes> vertex_source_planes(mesh, "VertexSourcePlanes");
+	FOR_EACH_HALFEDGE(Map, mesh, it) {
+		if (it->facet() == nil || vertex_source_planes[it->vertex()].size() == 3)
+			continue;
+		VertexSourcePlanes& vertex_planes = vertex_source_planes[it->vertex()];
+		const EdgeSourcePlanes& in = edge_source_planes[it];
+		const EdgeSourcePlanes& out = edge_source_planes[it->next()];
+		for (std::size_t k = 0; k < 2; ++k) {
+			vertex_planes.insert(in[k]);
+			vertex_planes.insert(out[k]);
+		}
+	}
+}
+
 
-	Plane3d* mid_plane = 0;
-	if (plane1 != min_plane && plane1 != max_plane)
-		mid_plane = plane1;
-	else if (plane2 != min_plane && plane2 != max_plane)
-		mid_plane = plane2;
-	else if (plane3 != min_plane && plane3 != max_plane)
-		mid_plane = plane3;
+void HypothesisGenerator::piecewise_cut(
+	Map* mesh,
+	CutAttributes& attribs,
+	const std::vector<MapTypes::Facet*>& faces,
+	std::vector< std::set<Plane3d*> >& cutting_planes,
+	int num_threads
+)
+{
+	// a single thread cuts the faces in place, which saves copying each face into its own mesh and 
+	// merging the pieces back
+	if (num_threads <= 1) {
+		ProgressLogger progress(faces.size());
+		for (std::size_t i = 0; i < faces.size(); ++i) {
+			if (!cutting_planes[i].empty())
+				cut_face(faces[i], cutting_planes[i], mesh, attribs);
+			progress.notify(i + 1);
+		}
+		return;
+	}
 
-	if (triplet_intersection_.find(min_plane) == triplet_intersection_.end())
-		return 0;
+	// The proxy faces are not connected, so each of them can be cut in its own mesh. Copying the 
+	// faces and merging the pieces is sequential because the attributes of 'mesh' are shared.
+	std::vector<std::size_t> tasks;
+	std::vector<Map*> pieces(faces.size(), nil);
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		if (cutting_planes[i].empty())
+			continue;
 
-	std::map<Plane3d*, std::map<Plane3d*, vec3*> >& tmp2 = triplet_intersection_[min_plane];
-	if (tmp2.find(mid_plane) == tmp2.end())
-		return 0;
+		Map* piece = new Map;
+		MapBuilder builder(piece);
+		builder.begin_surface();
+		int cur_vertex_id = 0;
+		append_facets(std::vector<MapTypes::Facet*>(1, faces[i]), mesh, builder, cur_vertex_id);
+		builder.end_surface();
+		complete_border_source_planes(piece);
 
-	std::map<Plane3d*, vec3*>& tmp3 = tmp2[mid_plane];
-	if (tmp3.find(max_plane) == tmp3.end())
-		return 0;
+		pieces[i] = piece;
+		tasks.push_back(i);
+	}
+	if (tasks.empty())
+		return;
+
+	// the progress is reported only by the calling thread (it may update a GUI)
+	ProgressLogger progress(tasks.size());
+	num_threads = std::min(num_threads, static_cast<int>(tasks.size()));
+	std::vector<TripletCache> caches(num_threads);
+	std::atomic<std::size_t> next_task(0);
+	std::atomic<std::size_t> num_done(0);
+
+	auto worker = [&](int thread_idx) {
+		for (std::size_t t = next_task++; t < tasks.size(); t = next_task++) {
+			std::size_t i = tasks[t];
+			Map* piece = pieces[i];
+			CutAttributes piece_attribs;
+			piece_attribs.bind(piece);
+			piece_attribs.triplets = &caches[thread_idx];
+
+			std::vector<MapTypes::Facet*> piece_faces;
+			FOR_EACH_FACET(Map, piece, it)
+				piece_faces.push_back(it);
+			cut_face(piece_faces[0], cutting_planes[i], piece, piece_attribs);
+
+			piece_attribs.unbind();
+
+			++num_done;
+			if (thread_idx == 0)
+				progress.notify(num_done);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < num_threads; ++i)
+		threads.push_back(std::thread(worker, i));
+	worker(0);
+	for (std::size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	progress.notify(tasks.size());
+	merge_triplet_caches(caches);
+
+	// replace the original faces by their pieces (in the order of the faces)
+	MapEditor editor(mesh);
+	for (std::size_t t = 0; t < tasks.size(); ++t)
+		editor.erase_facet(faces[tasks[t]]->halfedge());
 
-	return tmp3[max_plane];
+	MapBuilder builder(mesh);
+	builder.begin_surface();
+	int cur_vertex_id = 0;
+	for (std::size_t t = 0; t < tasks.size(); ++t) {
+		Map* piece = pieces[tasks[t]];
+		std::vector<MapTypes::Facet*> piece_faces;
+		FOR_EACH_FACET(Map, piece, it)
+			piece_faces.push_back(it);
+		append_facets(piece_faces, piece, builder, cur_vertex_id);
+		delete piece;
+	}
+	builder.end_surface();
+	complete_border_source_planes(mesh);
 }
 
 
+void HypothesisGenerator::arrange_face(const ProxyFace& face, FaceCells& result, TripletCache* triplets) {
+	const Plane3d* plane = supporting_planes_[face.plane];
+	const std::size_t num_corners = face.corners.size();
+
+	// the nodes of the arrangement (before merging the coincident ones)
+	std::vector<vec3>				positions;
+	std::vector<vec2>				projections;
+	std::vector<VertexSourcePlanes>	node_planes;
+	auto add_node = [&](const vec3& p, const VertexSourcePlanes& planes) -> int {
+		positions.push_back(p);
+		projections.push_back(plane->to_2d(p));
+		node_planes.push_back(planes);
+		return static_cast<int>(positions.size()) - 1;
+	};
+	auto source_planes = [&](unsigned int id1, unsigned int id2) -> VertexSourcePlanes {
+		VertexSourcePlanes planes;
+		planes.insert(face.plane);
+		planes.insert(id1);
+		planes.insert(id2);
+		return planes;
+	};
+
+	// a line (the boundary edges first, then the cutting lines) and the nodes on it
+	struct Line {
+		unsigned int	plane;
+		vec2			origin;
+		vec2			dir;
+		double			tmin, tmax;
+		std::vector< std::pair<double, int> >	nodes;	// (parameter, node)
+
+		double param(const vec2& q) const { return dot(q - origin, dir); }
+	};
+	std::vector<Line> lines;
+
+	for (std::size_t k = 0; k < num_corners; ++k)
+		add_node(face.corners[k], face.corner_planes[k]);
+	for (std::size_t k = 0; k < num_corners; ++k) {
+		std::size_t next = (k + 1) % num_corners;
+		Line line;
+		line.plane = face.edge_planes[k];
+		line.origin = projections[k];
+		line.dir = projections[next] - projections[k];
+		line.tmin = 0;
+		line.tmax = line.param(projections[next]);
+		line.nodes.push_back(std::make_pair(line.tmin, static_cast<int>(k)));
+		line.nodes.push_back(std::make_pair(line.tmax, static_cast<int>(next)));
+		lines.push_back(line);
+	}
 
-Map* HypothesisGenerator::generate() {
-	if (!pset_)
-		return nil;
+	// the cutting lines and their end points on the boundary
+	for (std::size_t m = 0; m < face.cutting_planes.size(); ++m) {
+		unsigned int id = face.cutting_planes[m];
+		const Plane3d* cutter = supporting_planes_[id];
 
-	if (pset_->groups().empty()) {
-		Logger::warn("-") << "planar segments do not exist" << std::endl;
-		return nil;
+		std::vector<int> ends;
+		for (std::size_t k = 0; k < num_corners; ++k) {
+			if (cutter->squared_ditance(face.corners[k]) <= Method::snap_sqr_distance_threshold)
+				ends.push_back(static_cast<int>(k));
+		}
+		std::vector<std::size_t> crossed_edges;
+		for (std::size_t k = 0; k < num_corners; ++k) {
+			const vec3& s = face.corners[k];
+			const vec3& t = face.corners[(k + 1) % num_corners];
+			if (cutter->squared_ditance(s) <= Method::snap_sqr_distance_threshold ||
+				cutter->squared_ditance(t) <= Method::snap_sqr_distance_threshold ||
+				!cutter->intersection(s, t))
+				continue;
+
+			vec3 p;
+			if (!query_intersection(face.plane, face.edge_planes[k], id, p, triplets) && !cutter->intersection(s, t, p))
+				continue;
+			ends.push_back(add_node(p, source_planes(face.edge_planes[k], id)));
+			crossed_edges.push_back(k);
+		}
+		if (ends.size() < 2)	// the plane touches the face at a single point
+			continue;
+
+		// the direction is given by the farthest end point (there may be more than two end points, 
+		// e.g., if the plane passes through a corner and crosses an edge near it)
+		std::size_t farthest = 1;
+		for (std::size_t i = 2; i < ends.size(); ++i) {
+			if (distance2(projections[ends[i]], projections[ends[0]]) > distance2(projections[ends[farthest]], projections[ends[0]]))
+				farthest = i;
+		}
+		Line line;
+		line.plane = id;
+		line.origin = projections[ends[0]];
+		line.dir = projections[ends[farthest]] - projections[ends[0]];
+		line.tmin = DBL_MAX;
+		line.tmax = -DBL_MAX;
+		for (std::size_t i = 0; i < ends.size(); ++i) {
+			double t = line.param(projections[ends[i]]);
+			line.tmin = std::min(line.tmin, t);
+			line.tmax = std::max(line.tmax, t);
+			line.nodes.push_back(std::make_pair(t, ends[i]));
+		}
+		if (line.tmax - line.tmin <= 0)
+			continue;
+
+		// the crossings are also on the boundary edges
+		std::size_t first_crossing = ends.size() - crossed_edges.size();
+		for (std::size_t i = 0; i < crossed_edges.size(); ++i) {
+			Line& edge = lines[crossed_edges[i]];
+			int node = ends[first_crossing + i];
+			edge.nodes.push_back(std::make_pair(edge.param(projections[node]), node));
+		}
+		lines.push_back(line);
 	}
 
-	collect_valid_planes();
+	// the intersections of the cutting lines inside the face
+	for (std::size_t i = num_corners; i < lines.size(); ++i) {
+		for (std::size_t j = i + 1; j < lines.size(); ++j) {
+			Line& l1 = lines[i];
+			Line& l2 = lines[j];
+			double det = l1.dir.x * l2.dir.y - l1.dir.y * l2.dir.x;
+			if (std::fabs(det) < 1e-20)
+				continue;
+			vec2 d = l2.origin - l1.origin;
+			double s1 = (d.x * l2.dir.y - d.y * l2.dir.x) / det;	// along l1, in units of l1.dir
+			double s2 = (d.x * l1.dir.y - d.y * l1.dir.x) / det;	// along l2, in units of l2.dir
+			double t1 = s1 * dot(l1.dir, l1.dir);
+			double t2 = s2 * dot(l2.dir, l2.dir);
+			if (t1 <= l1.tmin || t1 >= l1.tmax || t2 <= l2.tmin || t2 >= l2.tmax)
+				continue;
+
+			vec3 p;
+			if (!query_intersection(face.plane, l1.plane, l2.plane, p, triplets))
+				p = plane->to_3d(l1.origin + l1.dir * static_cast<float>(s1));
+			int node = add_node(p, source_planes(l1.plane, l2.plane));
+			l1.nodes.push_back(std::make_pair(l1.param(projections[node]), node));
+			l2.nodes.push_back(std::make_pair(l2.param(projections[node]), node));
+		}
+	}
 
-	Map* bbox_mesh = construct_bbox_mesh();
-	Map* mesh = compute_proxy_mesh(bbox_mesh);
-	if (!mesh)
-		return nil;
+	// the coincident nodes (i.e., consecutive on a line and within the snapping distance) are merged. A
+	// merged node is represented by its first node, so the corners are kept.
+	std::vector<int> parent(positions.size());
+	for (std::size_t i = 0; i < parent.size(); ++i)
+		parent[i] = static_cast<int>(i);
+	auto find = [&](int i) -> int {
+		while (parent[i] != i) {
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+	for (std::size_t i = 0; i < lines.size(); ++i) {
+		std::vector< std::pair<double, int> >& nodes = lines[i].nodes;
+		std::sort(nodes.begin(), nodes.end());
+		for (std::size_t j = 1; j < nodes.size(); ++j) {
+			int a = find(nodes[j - 1].second);
+			int b = find(nodes[j].second);
+			if (a != b && distance2(positions[a], positions[b]) <= Method::snap_sqr_distance_threshold)
+				parent[std::max(a, b)] = std::min(a, b);
+		}
+	}
 
-	check_source_planes(mesh);
+	// the edges of the planar graph (an edge shared by several lines is kept only once)
+	struct GraphHalfedge {
+		int				from, to;
+		unsigned int	plane;
+		double			angle;
+		bool			visited;
+	};
+	std::vector<GraphHalfedge> halfedges;
+	std::set< std::pair<int, int> > existing_edges;
+	std::vector<int> vertex_index(positions.size(), -1);
+	std::vector<int> vertices;
+	for (std::size_t i = 0; i < lines.size(); ++i) {
+		const std::vector< std::pair<double, int> >& nodes = lines[i].nodes;
+		int prev = -1;
+		for (std::size_t j = 0; j < nodes.size(); ++j) {
+			int cur = find(nodes[j].second);
+			if (prev != -1 && cur != prev && existing_edges.insert(std::make_pair(std::min(prev, cur), std::max(prev, cur))).second) {
+				const int ends[2] = { prev, cur };
+				for (int k = 0; k < 2; ++k) {
+					if (vertex_index[ends[k]] == -1) {
+						vertex_index[ends[k]] = static_cast<int>(vertices.size());
+						vertices.push_back(ends[k]);
+					}
+				}
+				for (int k = 0; k < 2; ++k) {
+					GraphHalfedge h;
+					h.from = vertex_index[ends[k]];
+					h.to = vertex_index[ends[1 - k]];
+					h.plane = lines[i].plane;
+					vec2 d = projections[ends[1 - k]] - projections[ends[k]];
+					h.angle = std::atan2(d.y, d.x);
+					h.visited = false;
+					halfedges.push_back(h);	// the opposite of halfedge i is i ^ 1
+				}
+			}
+			prev = cur;
+		}
+	}
 
-	facet_attrib_supporting_vertex_group_.bind(mesh, Method::facet_attrib_supporting_vertex_group);
-	facet_attrib_supporting_plane_.bind(mesh, "FacetSupportingPlane");
-	edge_source_planes_.bind(mesh, "EdgeSourcePlanes");
-	vertex_source_planes_.bind(mesh, "VertexSourcePlanes");
+	// the outgoing halfedges of each vertex, in counterclockwise order
+	std::vector< std::vector<int> > outgoing(vertices.size());
+	for (std::size_t i = 0; i < halfedges.size(); ++i)
+		outgoing[halfedges[i].from].push_back(static_cast<int>(i));
+	std::vector<int> position_around(halfedges.size());
+	for (std::size_t v = 0; v < outgoing.size(); ++v) {
+		std::vector<int>& around = outgoing[v];
+		std::sort(around.begin(), around.end(), [&](int a, int b) { return halfedges[a].angle < halfedges[b].angle; });
+		for (std::size_t i = 0; i < around.size(); ++i)
+			position_around[around[i]] = static_cast<int>(i);
+	}
 
-	triplet_intersection();
-	pairwise_cut(mesh);
-	check_source_planes(mesh);
+	// the cells are on the left of their halfedges. The next halfedge of (u -> v) is the one right 
+	// after (v -> u) in clockwise order around v. The outer boundary is traced clockwise and skipped.
+	Polygon2d boundary;
+	boundary.insert(boundary.end(), projections.begin(), projections.begin() + num_corners);
+	bool reversed = Geom::signed_area(boundary) < 0;	// the face is clockwise in the 2D coordinates
+
+	result.points.resize(vertices.size());
+	result.point_planes.resize(vertices.size());
+	for (std::size_t i = 0; i < vertices.size(); ++i) {
+		result.points[i] = positions[vertices[i]];
+		result.point_planes[i] = node_planes[vertices[i]];
+	}
 
-	remove_degenerated_facets(mesh);
-	check_source_planes(mesh);
+	for (std::size_t i = 0; i < halfedges.size(); ++i) {
+		if (halfedges[i].visited)
+			continue;
 
-	facet_attrib_supporting_vertex_group_.unbind();
-	facet_attrib_supporting_plane_.unbind();
-	edge_source_planes_.unbind();
-	vertex_source_planes_.unbind();
+		std::vector<int> cell;
+		std::vector<unsigned int> edge_planes;
+		Polygon2d polygon;
+		int h = static_cast<int>(i);
+		do {
+			halfedges[h].visited = true;
+			cell.push_back(halfedges[h].from);
+			edge_planes.push_back(halfedges[h].plane);
+			polygon.push_back(projections[vertices[halfedges[h].from]]);
 
-	return mesh;
+			const std::vector<int>& around = outgoing[halfedges[h].to];
+			int pos = position_around[h ^ 1];
+			h = around[(pos + around.size() - 1) % around.size()];
+		} while (h != static_cast<int>(i) && !halfedges[h].visited);
+
+		if (h != static_cast<int>(i) || cell.size() < 3 || Geom::signed_area(polygon) <= 0)
+			continue;
+
+		if (reversed) {	// the cells must have the orientation of the face
+			std::size_t n = cell.size();
+			std::vector<int> reversed_cell(n);
+			std::vector<unsigned int> reversed_planes(n);
+			for (std::size_t j = 0; j < n; ++j) {
+				reversed_cell[j] = cell[n - 1 - j];
+				reversed_planes[j] = edge_planes[(2 * n - 2 - j) % n];
+			}
+			cell.swap(reversed_cell);
+			edge_planes.swap(reversed_planes);
+		}
+		result.cells.push_back(cell);
+		result.edge_planes.push_back(edge_planes);
+	}
 }
 
 
-void HypothesisGenerator::clear() {
-	for (std::size_t i = 0; i < supporting_planes_.size(); ++i)
-		delete supporting_planes_[i];
-	supporting_planes_.clear();
+void HypothesisGenerator::extract_proxy_face(
+	MapTypes::Facet* f, 
+	const std::set<Plane3d*>& cutting_planes, 
+	CutAttributes& attribs, 
+	ProxyFace& face
+)
+{
+	face.plane = plane_id(attribs.supporting_plane[f]);
+	FacetHalfedgeCirculator cir(f);
+	for (; !cir->end(); ++cir) {
+		MapTypes::Halfedge* h = cir->halfedge();
+		face.corners.push_back(h->vertex()->point());
+		face.corner_planes.push_back(attribs.vertex_source_planes[h->vertex()]);
+
+		// the edge from this corner to the next one
+		const EdgeSourcePlanes& planes = attribs.edge_source_planes[h->next()];
+		face.edge_planes.push_back(planes[0] == face.plane ? planes[1] : planes[0]);
+	}
 
-	for (std::size_t i = 0; i < intersecting_points_.size(); ++i)
-		delete intersecting_points_[i];
-	intersecting_points_.clear();
+	std::set<Plane3d*>::const_iterator it = cutting_planes.begin();
+	for (; it != cutting_planes.end(); ++it)
+		face.cutting_planes.push_back(plane_id(*it));
 }
 
 
+void HypothesisGenerator::arrange_faces(
+	const std::vector<ProxyFace>& faces,
+	const std::vector<std::size_t>& tasks,
+	std::vector<FaceCells>& cells,
+	int num_threads
+)
+{
+	ProgressLogger progress(tasks.size());
+	cells.resize(faces.size());
+	num_threads = std::min(num_threads, static_cast<int>(std::max<std::size_t>(tasks.size(), 1)));
+	std::vector<TripletCache> caches(num_threads);
+	std::atomic<std::size_t> next_task(0);
+	std::atomic<std::size_t> num_done(0);
+	auto worker = [&](int thread_idx) {
+		for (std::size_t t = next_task++; t < tasks.size(); t = next_task++) {
+			std::size_t i = tasks[t];
+			arrange_face(faces[i], cells[i], &caches[thread_idx]);
+
+			++num_done;
+			if (thread_idx == 0)	// the progress is reported only by the calling thread
+				progress.notify(num_done);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < num_threads; ++i)
+		threads.push_back(std::thread(worker, i));
+	worker(0);
+	for (std::size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	merge_triplet_caches(caches);
+	progress.notify(tasks.size());
+}
 
 
-float HypothesisGenerator::compute_point_confidences(PointSet* pset, int s1 /* = 6 */, int s2 /* = 16 */, int s3 /* = 32 */, ProgressLogger* progress) {
-	std::vector<vec3>& points = pset->points();
-	std::vector<float>& planar_qualities = pset->planar_qualities();
-
-	if (planar_qualities.size() != points.size())
-		planar_qualities.resize(points.size());
+std::size_t HypothesisGenerator::replace_faces_by_cells(
+	Map* mesh,
+	CutAttributes& attribs,
+	const std::vector<MapTypes::Facet*>& faces,
+	const std::vector<std::size_t>& tasks,
+	const std::vector<ProxyFace>& inputs,
+	const std::vector<FaceCells>& outputs
+)
+{
+	MapFacetAttribute<Color> color(mesh, "color");
 
-	KdTreeSearch_var kdtree = new KdTreeSearch;
-	kdtree->begin();
-	kdtree->add_vertex_set(pset);
-	kdtree->end();
+	std::vector<Color> colors(faces.size());
+	std::vector<VertexGroup*> groups(faces.size());
+	std::vector<Plane3d*> planes(faces.size());
+	for (std::size_t t = 0; t < tasks.size(); ++t) {
+		MapTypes::Facet* f = faces[tasks[t]];
+		colors[tasks[t]] = color[f];
+		groups[tasks[t]] = attribs.supporting_vertex_group[f];
+		planes[tasks[t]] = attribs.supporting_plane[f];
+	}
 
-	std::vector<int> neighbor_size;
-	neighbor_size.push_back(s1);
-	neighbor_size.push_back(s2);
-	neighbor_size.push_back(s3);
+	MapEditor editor(mesh);
+	for (std::size_t t = 0; t < tasks.size(); ++t)
+		editor.erase_facet(faces[tasks[t]]->halfedge());
 
-	std::vector< std::vector<double> > eigen_values(3);
-	for (int i = 0; i < 3; ++i)
-		eigen_values[i].resize(3);
+	std::size_t num_cells = 0;
+	MapBuilder builder(mesh);
+	builder.begin_surface();
+	int cur_vertex_id = 0;
+	for (std::size_t t = 0; t < tasks.size(); ++t) {
+		std::size_t i = tasks[t];
+		const FaceCells& output = outputs[i];
+
+		int first_vertex_id = cur_vertex_id;
+		std::map<Map::Vertex*, int> point_index;
+		for (std::size_t j = 0; j < output.points.size(); ++j) {
+			builder.add_vertex(output.points[j]);
+			point_index[builder.current_vertex()] = static_cast<int>(j);
+			attribs.vertex_source_planes[builder.current_vertex()] = output.point_planes[j];
+			++cur_vertex_id;
+		}
 
-	double total = 0;
-	for (std::size_t i = 0; i < points.size(); ++i) {
-		const vec3& p = points[i];
-		for (int j = 0; j < 3; ++j) {
-			std::vector<unsigned int> neighbors;
-			std::vector<double> sqr_distances;
-			kdtree->find_closest_K_points(p, neighbor_size[j], neighbors, sqr_distances);
-
-			PrincipalAxes3d pca;
-			pca.begin();
-			double avg = 0;
-			for (unsigned int k = 0; k < neighbors.size(); ++k) {
-				pca.add_point(points[neighbors[k]]);
-				if (j == 0) {
-					avg += std::sqrt(sqr_distances[k]);
-				}
-			}
-			pca.end();
-			total += (avg / neighbors.size());
+		for (std::size_t c = 0; c < output.cells.size(); ++c) {
+			const std::vector<int>& cell = output.cells[c];
+			builder.begin_facet();
+			for (std::size_t j = 0; j < cell.size(); ++j)
+				builder.add_vertex_to_facet(first_vertex_id + cell[j]);
+			builder.end_facet();
 
-			for (int k = 0; k < 3; ++k)
-				eigen_values[j][k] = pca.eigen_value(3 - k - 1); // eigen values are sorted in descending order
+			Map::Facet* g = builder.current_facet();
+			color[g] = colors[i];
+			attribs.supporting_vertex_group[g] = groups[i];
+			attribs.supporting_plane[g] = planes[i];
 
-			assert(eigen_values[j][0] <= eigen_values[j][1] && eigen_values[j][1] <= eigen_values[j][2]);
+			// the halfedge pointing to point j is the edge from point j - 1
+			FacetHalfedgeCirculator cir(g);
+			for (; !cir->end(); ++cir) {
+				MapTypes::Halfedge* h = cir->halfedge();
+				std::size_t j = std::find(cell.begin(), cell.end(), point_index[h->vertex()]) - cell.begin();
+				EdgeSourcePlanes edge_planes;
+				edge_planes.insert(inputs[i].plane);
+				edge_planes.insert(output.edge_planes[c][(j + cell.size() - 1) % cell.size()]);
+				attribs.edge_source_planes[h] = edge_planes;
+			}
+			++num_cells;
 		}
+	}
+	builder.end_surface();
+	complete_border_source_planes(mesh);
 
-		double conf = 0.0;
-		for (int j = 0; j < 3; ++j) {
-			conf += (1 - 3.0 * eigen_values[j][0] / (eigen_values[j][0] + eigen_values[j][1] + eigen_values[j][2])) * (eigen_values[j][1] / eigen_values[j][2]);
-		}
-		conf /= 3.0;
-		planar_qualities[i] = static_cast<float>(conf);
+	complete_split_vertex_source_planes(mesh);
 
-		if (progress)
-		    progress->next();
-	}
-	return static_cast<float>(total / points.size());
+	return num_cells;
 }
 
 
-void HypothesisGenerator::compute_confidences(Map* mesh, bool use_conficence /* = false */) {
-	facet_attrib_supporting_vertex_group_.bind(mesh, Method::facet_attrib_supporting_vertex_group);
+void HypothesisGenerator::arrangement_pairwise_cut(
+	Map* mesh,
+	CutAttributes& attribs,
+	const std::vector<MapTypes::Facet*>& faces,
+	const std::vector< std::set<Plane3d*> >& cutting_planes,
+	int num_threads
+)
+{
+	// the faces are extracted sequentially (the attributes of 'mesh' are shared) ...
+	std::vector<std::size_t> tasks;
+	std::vector<ProxyFace> inputs(faces.size());
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		if (cutting_planes[i].empty())
+			continue;
+		extract_proxy_face(faces[i], cutting_planes[i], attribs, inputs[i]);
+		tasks.push_back(i);
+	}
+
+	// ... and arranged concurrently
+	std::vector<FaceCells> outputs;
+	arrange_faces(inputs, tasks, outputs, num_threads);
+
+	// replace the original faces by their cells (in the order of the faces)
+	std::size_t num_cells = replace_faces_by_cells(mesh, attribs, faces, tasks, inputs, outputs);
+
+	Logger::out("-") << "line arrangement: " << tasks.size() << " faces cut into " << num_cells << " cells" << std::endl;
+}
+
+
+namespace {
+
+	double point_segment_distance2(const vec2& p, const vec2& a, const vec2& b) {
+		vec2 ab = b - a;
+		double len2 = dot(ab, ab);
+		double t = (len2 > 0) ? dot(p - a, ab) / len2 : 0.0;
+		t = std::max(0.0, std::min(1.0, t));
+		vec2 q = a + ab * static_cast<float>(t);
+		return distance2(p, q);
+	}
+
+	double cross2(const vec2& o, const vec2& a, const vec2& b) {
+		return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+	}
+
+	bool segments_intersect(const vec2& a, const vec2& b, const vec2& c, const vec2& d) {
+		double d1 = cross2(c, d, a), d2 = cross2(c, d, b);
+		double d3 = cross2(a, b, c), d4 = cross2(a, b, d);
+		return ((d1 > 0) != (d2 > 0)) && ((d3 > 0) != (d4 > 0));
+	}
+
+	// the distance from a convex polygon (which may also be a point or a segment) to segment [a, b]
+	double distance_to_convex(const Polygon2d& convex, const vec2& a, const vec2& b) {
+		std::size_t n = convex.size();
+		if (n >= 3 && (Geom::point_is_in_polygon(convex, a) || Geom::point_is_in_polygon(convex, b)))
+			return 0.0;
+
+		double d2 = DBL_MAX;
+		for (std::size_t i = 0, j = n - 1; i < n; j = i, ++i) {
+			const vec2& c = convex[j];
+			const vec2& d = convex[i];
+			if (segments_intersect(a, b, c, d))
+				return 0.0;
+			d2 = std::min(d2, point_segment_distance2(a, c, d));
+			d2 = std::min(d2, point_segment_distance2(b, c, d));
+			d2 = std::min(d2, point_segment_distance2(c, a, b));
+		}
+		return std::sqrt(d2);
+	}
+
+	// the convex hull of 'convex' dilated by an octagon around each of its vertices (the octagon covers
+	// the disk of radius 'dilation')
+	void dilate_convex(const Polygon2d& convex, double dilation, Polygon2d& result) {
+		const double radius = dilation / std::cos(M_PI / 8.0);
+		Polygon2d points;
+		for (std::size_t i = 0; i < convex.size(); ++i) {
+			for (int k = 0; k < 8; ++k) {
+				double angle = k * M_PI / 4.0;
+				points.push_back(convex[i] + vec2(static_cast<float>(radius * std::cos(angle)), static_cast<float>(radius * std::sin(angle))));
+			}
+		}
+		result.clear();
+		Geom::convex_hull(points, result);
+		if (Geom::signed_area(result) < 0)
+			std::reverse(result.begin(), result.end());
+	}
+
+	// the range [a, b] of the positions (along 'dir') at which a convex 3D polygon crosses 'plane'.
+	// Returns false if the polygon is on one side of the plane.
+	bool plane_crossing(const std::vector<vec3>& polygon, const Plane3d* plane, const vec3& dir, double& a, double& b) {
+		a = DBL_MAX;
+		b = -DBL_MAX;
+		const std::size_t n = polygon.size();
+		for (std::size_t i = 0, j = n - 1; i < n; j = i, ++i) {
+			double vi = plane->value(polygon[i]);
+			double vj = plane->value(polygon[j]);
+			double t;
+			if (vi == 0)
+				t = dot(polygon[i], dir);
+			else if (vj != 0 && (vi > 0) != (vj > 0))
+				t = dot(polygon[j] + (polygon[i] - polygon[j]) * static_cast<float>(vj / (vj - vi)), dir);
+			else
+				continue;
+			a = std::min(a, t);
+			b = std::max(b, t);
+		}
+		return a <= b;
+	}
+
+}
+
+
+void HypothesisGenerator::kinetic_partition(Map* mesh, CutAttributes& attribs, int num_threads) {
+	std::vector<MapTypes::Facet*> faces;
+	std::vector< std::set<Plane3d*> > candidates;	// the planes that may cut each face
+	collect_all_cutting_planes(mesh, attribs, faces, candidates);
+
+	// The lines are added on demand: a proxy face is only cut by the planes whose polygons collide with
+	// its own polygon (see below), so its arrangement is much smaller than the one of all the planes
+	// crossing it. All the faces start uncut, i.e., as a single cell.
+	std::vector<ProxyFace> inputs(faces.size());
+	std::vector<int> face_of_plane(supporting_planes_.size(), -1);	// -1 for the planes of the box
+	const std::set<Plane3d*> no_planes;
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		extract_proxy_face(faces[i], no_planes, attribs, inputs[i]);
+		face_of_plane[inputs[i].plane] = static_cast<int>(i);
+	}
+	std::vector< std::set<unsigned int> > cutters(faces.size());	// the planes actually cutting each face
+	std::vector<FaceCells> arrangements(faces.size());
+
+	// The edges of the cells are located on the intersecting line of the two planes by their positions
+	// along the line, which are the same for the faces of both planes.
+	auto line_dir = [&](unsigned int id1, unsigned int id2) -> vec3 {
+		const Plane3d* plane1 = supporting_planes_[std::min(id1, id2)];
+		const Plane3d* plane2 = supporting_planes_[std::max(id1, id2)];
+		return normalize(cross(plane1->normal(), plane2->normal()));
+	};
+
+	struct KineticFace {
+		Polygon2d					hull;		// the convex hull of the supporting points
+		std::vector<Polygon2d>		polygons;	// the cells in 2D
+		std::vector<std::size_t>	first_edge;	// the edges of cell c are in [first_edge[c], first_edge[c + 1])
+		std::vector<unsigned int>	plane;		// the other plane of each edge of the cells
+		std::vector< std::pair<double, double> >	span;	// the range of each edge on its line
+		std::vector<int>			neighbor;	// the cell on the other side of each edge (-1 if none)
+		std::vector<bool>			active;		// the cells covered by the growing polygon
+	};
+	std::vector<KineticFace> kinetic(faces.size());
+
+	const std::vector<vec3>& points = pset_->points();
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		const Plane3d* plane = supporting_planes_[inputs[i].plane];
+		VertexGroup* g = attribs.supporting_vertex_group[faces[i]];
+		Polygon2d projected;
+		for (std::size_t j = 0; j < g->size(); ++j)
+			projected.push_back(plane->to_2d(points[g->at(j)]));
+		if (!projected.empty()) {
+			Geom::convex_hull(projected, kinetic[i].hull);
+			if (Geom::signed_area(kinetic[i].hull) < 0)
+				std::reverse(kinetic[i].hull.begin(), kinetic[i].hull.end());
+		}
+	}
+
+	auto build = [&](std::size_t i) {
+		const FaceCells& arrangement = arrangements[i];
+		const Plane3d* plane = supporting_planes_[inputs[i].plane];
+		KineticFace& face = kinetic[i];
+		face.polygons.clear();
+		face.first_edge.assign(1, 0);
+		face.plane.clear();
+		face.span.clear();
+		face.neighbor.clear();
+
+		std::map< std::pair<int, int>, std::size_t > edge_of_points;	// the first edge between two points
+		for (std::size_t c = 0; c < arrangement.cells.size(); ++c) {
+			const std::vector<int>& cell = arrangement.cells[c];
+			Polygon2d polygon;
+			for (std::size_t j = 0; j < cell.size(); ++j) {
+				int s = cell[j];
+				int t = cell[(j + 1) % cell.size()];
+				polygon.push_back(plane->to_2d(arrangement.points[s]));
+
+				unsigned int other = arrangement.edge_planes[c][j];
+				vec3 dir = line_dir(inputs[i].plane, other);
+				double ts = dot(arrangement.points[s], dir);
+				double tt = dot(arrangement.points[t], dir);
+				face.plane.push_back(other);
+				face.span.push_back(std::make_pair(std::min(ts, tt), std::max(ts, tt)));
+				face.neighbor.push_back(-1);
+
+				std::pair<int, int> points_key(std::min(s, t), std::max(s, t));
+				std::size_t e = face.plane.size() - 1;
+				std::map< std::pair<int, int>, std::size_t >::iterator pos = edge_of_points.find(points_key);
+				if (pos == edge_of_points.end())
+					edge_of_points[points_key] = e;
+				else {
+					std::size_t other_cell = std::upper_bound(face.first_edge.begin(), face.first_edge.end(), pos->second) - face.first_edge.begin() - 1;
+					face.neighbor[e] = static_cast<int>(other_cell);
+					face.neighbor[pos->second] = static_cast<int>(c);
+				}
+			}
+			face.polygons.push_back(polygon);
+			face.first_edge.push_back(face.plane.size());
+		}
+	};
+
+	// Kinetic propagation: all the polygons start from the convex hulls of their points and grow at the
+	// same speed. A polygon crosses an edge of its cells unless the other plane of the edge has reached
+	// it first, i.e., a polygon stops when it hits another one. The events (a polygon reaching an edge)
+	// are processed in the order of time, which is the distance from the hull to the edge.
+	struct Event {
+		double	time;
+		int		face;
+		int		cell;
+		int		edge;	// the index of the edge in the face
+
+		bool operator<(const Event& rhs) const {	// the earliest event on top of the priority queue
+			if (time != rhs.time) return time > rhs.time;
+			if (face != rhs.face) return face > rhs.face;
+			return edge > rhs.edge;
+		}
+	};
+	std::priority_queue<Event> events;
+
+	// the edges reached by the polygons, on the line of the two planes of the edges
+	struct Arrival {
+		int		face;
+		double	a, b;
+	};
+	typedef std::pair<unsigned int, unsigned int> LineKey;
+	std::map< LineKey, std::vector<Arrival> > arrivals;
+	const double tolerance = std::sqrt(Method::snap_sqr_distance_threshold);
+	auto line_key = [&](int i, std::size_t e) -> LineKey {
+		unsigned int id1 = inputs[i].plane;
+		unsigned int id2 = kinetic[i].plane[e];
+		return LineKey(std::min(id1, id2), std::max(id1, id2));
+	};
+	auto has_arrived = [&](int i, std::size_t e, int face) -> bool {	// if 'face' has reached edge e of face i
+		if (face < 0)
+			return false;
+		std::map< LineKey, std::vector<Arrival> >::const_iterator pos = arrivals.find(line_key(i, e));
+		if (pos == arrivals.end())
+			return false;
+		const std::pair<double, double>& span = kinetic[i].span[e];
+		for (std::size_t k = 0; k < pos->second.size(); ++k) {
+			const Arrival& r = pos->second[k];
+			double overlap = std::min(r.b, span.second) - std::max(r.a, span.first);
+			if (r.face == face && overlap > 0.5 * std::min(tolerance, std::min(r.b - r.a, span.second - span.first)))
+				return true;
+		}
+		return false;
+	};
+	auto arrive = [&](int i, std::size_t e) {
+		std::vector<Arrival>& records = arrivals[line_key(i, e)];
+		const std::pair<double, double>& span = kinetic[i].span[e];
+		for (std::size_t k = 0; k < records.size(); ++k) {
+			if (records[k].face == i && records[k].a == span.first && records[k].b == span.second)
+				return;
+		}
+		Arrival r;
+		r.face = i;
+		r.a = span.first;
+		r.b = span.second;
+		records.push_back(r);
+	};
+	auto other_face = [&](int i, std::size_t e) -> int {	// the face of the other plane of an edge
+		return face_of_plane[kinetic[i].plane[e]];
+	};
+
+	auto activate = [&](int i, int c, double time) {
+		KineticFace& face = kinetic[i];
+		face.active[c] = true;
+		const Polygon2d& polygon = face.polygons[c];
+		for (std::size_t j = 0; j < polygon.size(); ++j) {
+			Event e;
+			e.time = std::max(time, distance_to_convex(face.hull, polygon[j], polygon[(j + 1) % polygon.size()]));
+			e.face = i;
+			e.cell = c;
+			e.edge = static_cast<int>(face.first_edge[c] + j);
+			events.push(e);
+		}
+	};
+
+	// the initial polygons: the cells overlapping the hulls (or the cell containing the center of the
+	// points if the hull is degenerate)
+	std::size_t num_collisions = 0;
+	auto restart = [&]() {
+		events = std::priority_queue<Event>();
+		arrivals.clear();
+		num_collisions = 0;
+		for (std::size_t i = 0; i < faces.size(); ++i) {
+			KineticFace& face = kinetic[i];
+			face.active.assign(face.polygons.size(), false);
+			if (face.hull.empty())
+				continue;
+			bool found = false;
+			if (face.hull.size() >= 3) {
+				for (std::size_t c = 0; c < face.polygons.size(); ++c) {
+					Polygon2d overlap;
+					Geom::convex_clip_polygon(face.polygons[c], face.hull, overlap);
+					if (overlap.size() >= 3 && Geom::area(overlap) > Method::snap_sqr_distance_threshold) {
+						activate(static_cast<int>(i), static_cast<int>(c), 0.0);
+						found = true;
+					}
+				}
+			}
+			if (!found) {
+				vec2 center = Geom::vertices_barycenter(face.hull);
+				for (std::size_t c = 0; c < face.polygons.size(); ++c) {
+					if (Geom::point_is_in_polygon(face.polygons[c], center)) {
+						activate(static_cast<int>(i), static_cast<int>(c), 0.0);
+						break;
+					}
+				}
+			}
+		}
+	};
+
+	// processes the events up to time 'horizon'
+	auto propagate = [&](double horizon) {
+		while (!events.empty() && events.top().time <= horizon) {
+			Event e = events.top();
+			events.pop();
+
+			arrive(e.face, e.edge);
+			int other = other_face(e.face, e.edge);
+			if (other < 0)	// the boundary of the box
+				continue;
+			if (has_arrived(e.face, e.edge, other)) {
+				++num_collisions;
+				continue;
+			}
+
+			KineticFace& face = kinetic[e.face];
+			int next = face.neighbor[e.edge];
+			if (next >= 0 && !face.active[next])
+				activate(e.face, next, e.time);
+		}
+	};
+
+	// Two polygons collide if they cross each other along their intersecting line. A face is not cut
+	// by the plane of a polygon until they collide, so a polygon may cover a cell far beyond its front
+	// (i.e., its hull dilated by the time). So while the polygons are still growing, only the pieces of
+	// the cells behind the fronts are checked. Returns the number of new collisions, whose planes are
+	// added to the cutting planes of both faces.
+	std::vector<bool> changed(faces.size(), true);
+	auto detect_collisions = [&](double horizon, bool growing) -> std::size_t {
+		std::vector< std::vector< std::vector<vec3> > > pieces(faces.size());
+		std::vector<Box3d> boxes(faces.size());
+		for (std::size_t i = 0; i < faces.size(); ++i) {
+			const KineticFace& face = kinetic[i];
+			const Plane3d* plane = supporting_planes_[inputs[i].plane];
+			Polygon2d front;
+			if (growing && !face.hull.empty())
+				dilate_convex(face.hull, horizon, front);
+			for (std::size_t c = 0; c < face.polygons.size(); ++c) {
+				if (!face.active[c])
+					continue;
+				Polygon2d piece;
+				if (growing)
+					Geom::convex_clip_polygon(face.polygons[c], front, piece);
+				else
+					piece = face.polygons[c];
+				if (piece.size() < 3)
+					continue;
+				std::vector<vec3> polygon(piece.size());
+				for (std::size_t j = 0; j < piece.size(); ++j) {
+					polygon[j] = plane->to_3d(piece[j]);
+					boxes[i].add_point(polygon[j]);
+				}
+				pieces[i].push_back(polygon);
+			}
+		}
+
+		std::size_t num_new = 0;
+		for (std::size_t i = 0; i < faces.size(); ++i) {
+			if (!boxes[i].initialized())
+				continue;
+			unsigned int id1 = inputs[i].plane;
+			std::set<Plane3d*>::const_iterator it = candidates[i].begin();
+			for (; it != candidates[i].end(); ++it) {
+				unsigned int id2 = plane_id(*it);
+				int j = face_of_plane[id2];
+				if (j < 0 || j == static_cast<int>(i) || !boxes[j].initialized() || cutters[i].find(id2) != cutters[i].end())
+					continue;
+				if (j < static_cast<int>(i) && candidates[j].find(supporting_planes_[id1]) != candidates[j].end())
+					continue;	// already checked with face j
+
+				const Box3d& a = boxes[i];
+				const Box3d& b = boxes[j];
+				if (a.x_max() + tolerance < b.x_min() || b.x_max() + tolerance < a.x_min() ||
+					a.y_max() + tolerance < b.y_min() || b.y_max() + tolerance < a.y_min() ||
+					a.z_max() + tolerance < b.z_min() || b.z_max() + tolerance < a.z_min())
+					continue;
+
+				vec3 dir = line_dir(id1, id2);
+				std::vector< std::pair<double, double> > ranges;
+				double s, t;
+				for (std::size_t k = 0; k < pieces[i].size(); ++k) {
+					if (plane_crossing(pieces[i][k], supporting_planes_[id2], dir, s, t))
+						ranges.push_back(std::make_pair(s, t));
+				}
+				bool collide = false;
+				for (std::size_t k = 0; k < pieces[j].size() && !ranges.empty() && !collide; ++k) {
+					if (!plane_crossing(pieces[j][k], supporting_planes_[id1], dir, s, t))
+						continue;
+					for (std::size_t m = 0; m < ranges.size() && !collide; ++m)
+						collide = std::min(t, ranges[m].second) - std::max(s, ranges[m].first) > tolerance;
+				}
+				if (collide) {
+					cutters[i].insert(id2);
+					cutters[j].insert(id1);
+					changed[i] = changed[j] = true;
+					++num_new;
+				}
+			}
+		}
+		return num_new;
+	};
+
+	// The time horizon is doubled until all the polygons stop. After new collisions, the faces are
+	// arranged again with the new lines and the propagation restarts (with the same horizon).
+	double horizon = mesh->bbox().radius() * 0.01;
+	std::size_t num_rounds = 0;
+	for (;;) {
+		std::vector<std::size_t> tasks;
+		for (std::size_t i = 0; i < faces.size(); ++i) {
+			if (!changed[i])
+				continue;
+			inputs[i].cutting_planes.assign(cutters[i].begin(), cutters[i].end());
+			arrangements[i] = FaceCells();
+			changed[i] = false;
+			tasks.push_back(i);
+		}
+		if (!tasks.empty()) {
+			arrange_faces(inputs, tasks, arrangements, num_threads);
+			for (std::size_t t = 0; t < tasks.size(); ++t)
+				build(tasks[t]);
+			restart();
+		}
+		++num_rounds;
+
+		propagate(horizon);
+		bool growing = !events.empty();
+		if (detect_collisions(horizon, growing) > 0)
+			continue;
+		if (!growing)
+			break;
+		horizon *= 2;
+	}
+
+	// The cells of a plane are merged if the edge between them is not reached by the other plane. The
+	// boundary of a merged face is traced from the boundary edges of its cells, and if the face is not
+	// a simple polygon (e.g., it has holes), its cells are kept.
+	std::vector<FaceCells> outputs(faces.size());
+	std::size_t num_cells = 0, num_active = 0, num_unmerged = 0;
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		const FaceCells& arrangement = arrangements[i];
+		const KineticFace& face = kinetic[i];
+		num_cells += arrangement.cells.size();
+
+		std::vector<int> parent(arrangement.cells.size());
+		for (std::size_t c = 0; c < parent.size(); ++c)
+			parent[c] = static_cast<int>(c);
+		for (std::size_t c = 0; c < arrangement.cells.size(); ++c) {
+			if (!face.active[c])
+				continue;
+			++num_active;
+			for (std::size_t e = face.first_edge[c]; e < face.first_edge[c + 1]; ++e) {
+				int next = face.neighbor[e];
+				if (next >= 0 && face.active[next] && !has_arrived(static_cast<int>(i), e, other_face(static_cast<int>(i), e)))
+					parent[find_root(parent, next)] = find_root(parent, static_cast<int>(c));
+			}
+		}
+
+		// the boundary edges (from point, to point, plane) of each merged face
+		struct BoundaryEdge {
+			int				s, t;
+			unsigned int	plane;
+		};
+		std::map< int, std::vector<BoundaryEdge> > boundaries;	// root -> edges
+		std::map< int, std::vector<int> > members;				// root -> cells
+		std::set<int> invalid;
+		for (std::size_t c = 0; c < arrangement.cells.size(); ++c) {
+			if (!face.active[c])
+				continue;
+			int root = find_root(parent, static_cast<int>(c));
+			members[root].push_back(static_cast<int>(c));
+
+			const std::vector<int>& cell = arrangement.cells[c];
+			for (std::size_t j = 0; j < cell.size(); ++j) {
+				std::size_t e = face.first_edge[c] + j;
+				int next = face.neighbor[e];
+				if (next >= 0 && face.active[next] && find_root(parent, next) == root) {
+					if (has_arrived(static_cast<int>(i), e, other_face(static_cast<int>(i), e)))
+						invalid.insert(root);	// a slit inside the face
+					continue;
+				}
+				BoundaryEdge b;
+				b.s = cell[j];
+				b.t = cell[(j + 1) % cell.size()];
+				b.plane = arrangement.edge_planes[c][j];
+				boundaries[root].push_back(b);
+			}
+		}
+		FaceCells& output = outputs[i];
+		std::vector<int> point_index(arrangement.points.size(), -1);	// only the used points are kept
+		auto add_polygon = [&](const std::vector<int>& polygon, const std::vector<unsigned int>& planes) {
+			std::vector<int> cell(polygon.size());
+			for (std::size_t j = 0; j < polygon.size(); ++j) {
+				int p = polygon[j];
+				if (point_index[p] == -1) {
+					point_index[p] = static_cast<int>(output.points.size());
+					output.points.push_back(arrangement.points[p]);
+					output.point_planes.push_back(arrangement.point_planes[p]);
+				}
+				cell[j] = point_index[p];
+			}
+			output.cells.push_back(cell);
+			output.edge_planes.push_back(planes);
+		};
+
+		std::map< int, std::vector<int> >::const_iterator it = members.begin();
+		for (; it != members.end(); ++it) {
+			int root = it->first;
+			const std::vector<BoundaryEdge>& edges = boundaries[root];
+
+			std::vector<int> polygon;
+			std::vector<unsigned int> planes;
+			if (invalid.find(root) == invalid.end()) {
+				std::map<int, std::size_t> edge_from;
+				bool simple = true;
+				for (std::size_t k = 0; k < edges.size() && simple; ++k)
+					simple = edge_from.insert(std::make_pair(edges[k].s, k)).second;
+
+				// a single cycle through all the boundary edges
+				std::size_t k = 0;
+				while (simple) {
+					polygon.push_back(edges[k].s);
+					planes.push_back(edges[k].plane);
+					std::map<int, std::size_t>::const_iterator pos = edge_from.find(edges[k].t);
+					if (pos == edge_from.end())
+						simple = false;
+					else
+						k = pos->second;
+					if (k == 0 || polygon.size() >= edges.size())
+						break;
+				}
+				if (!simple || k != 0 || polygon.size() != edges.size() || polygon.size() < 3)
+					polygon.clear();
+			}
+
+			if (!polygon.empty())
+				add_polygon(polygon, planes);
+			else {
+				++num_unmerged;
+				const std::vector<int>& cells = it->second;
+				for (std::size_t c = 0; c < cells.size(); ++c)
+					add_polygon(arrangement.cells[cells[c]], arrangement.edge_planes[cells[c]]);
+			}
+		}
+	}
+
+	// The faces of two planes may have different points on their intersecting line, because each face
+	// is only cut by the planes of its own collisions. The points of both faces on the line are inserted
+	// into the edges on the line, so that the faces share the edges (see extract_adjacency()).
+	struct LinePoint {
+		double				t;	// the position on the line
+		vec3				p;
+		VertexSourcePlanes	planes;
+	};
+	std::map< LineKey, std::map<PlaneTripletTable::Key, LinePoint> > line_points;
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		const FaceCells& output = outputs[i];
+		unsigned int id1 = inputs[i].plane;
+		for (std::size_t k = 0; k < output.points.size(); ++k) {
+			const VertexSourcePlanes& planes = output.point_planes[k];
+			for (std::size_t m = 0; m < 3; ++m) {
+				unsigned int id2 = planes[m];
+				if (id2 == id1 || face_of_plane[id2] < 0)
+					continue;
+				LinePoint lp;
+				lp.t = dot(output.points[k], line_dir(id1, id2));
+				lp.p = output.points[k];
+				lp.planes = planes;
+				line_points[LineKey(std::min(id1, id2), std::max(id1, id2))][PlaneTripletTable::key(planes[0], planes[1], planes[2])] = lp;
+			}
+		}
+	}
+
+	std::size_t num_inserted = 0;
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		FaceCells& output = outputs[i];
+		unsigned int id1 = inputs[i].plane;
+		std::map<PlaneTripletTable::Key, int> point_index;
+		for (std::size_t k = 0; k < output.points.size(); ++k) {
+			const VertexSourcePlanes& planes = output.point_planes[k];
+			point_index[PlaneTripletTable::key(planes[0], planes[1], planes[2])] = static_cast<int>(k);
+		}
+
+		for (std::size_t c = 0; c < output.cells.size(); ++c) {
+			const std::vector<int>& cell = output.cells[c];
+			std::vector<int> new_cell;
+			std::vector<unsigned int> new_planes;
+			for (std::size_t j = 0; j < cell.size(); ++j) {
+				int s = cell[j];
+				int t = cell[(j + 1) % cell.size()];
+				unsigned int id2 = output.edge_planes[c][j];
+				new_cell.push_back(s);
+				new_planes.push_back(id2);
+				if (face_of_plane[id2] < 0)
+					continue;
+
+				std::map< LineKey, std::map<PlaneTripletTable::Key, LinePoint> >::const_iterator pos = line_points.find(LineKey(std::min(id1, id2), std::max(id1, id2)));
+				if (pos == line_points.end())
+					continue;
+				vec3 dir = line_dir(id1, id2);
+				double ts = dot(output.points[s], dir);
+				double tt = dot(output.points[t], dir);
+				std::vector< std::pair<double, const LinePoint*> > inside;	// (distance from s, point)
+				std::map<PlaneTripletTable::Key, LinePoint>::const_iterator it = pos->second.begin();
+				for (; it != pos->second.end(); ++it) {
+					const LinePoint& lp = it->second;
+					if (lp.t <= std::min(ts, tt) || lp.t >= std::max(ts, tt) ||
+						distance2(lp.p, output.points[s]) <= Method::snap_sqr_distance_threshold ||
+						distance2(lp.p, output.points[t]) <= Method::snap_sqr_distance_threshold)
+						continue;
+					inside.push_back(std::make_pair(std::fabs(lp.t - ts), &lp));
+				}
+				std::sort(inside.begin(), inside.end());
+				for (std::size_t k = 0; k < inside.size(); ++k) {
+					const LinePoint& lp = *inside[k].second;
+					PlaneTripletTable::Key key = PlaneTripletTable::key(lp.planes[0], lp.planes[1], lp.planes[2]);
+					std::map<PlaneTripletTable::Key, int>::iterator index = point_index.find(key);
+					if (index == point_index.end()) {
+						index = point_index.insert(std::make_pair(key, static_cast<int>(output.points.size()))).first;
+						output.points.push_back(lp.p);
+						output.point_planes.push_back(lp.planes);
+					}
+					new_cell.push_back(index->second);
+					new_planes.push_back(id2);
+					++num_inserted;
+				}
+			}
+			output.cells[c].swap(new_cell);
+			output.edge_planes[c].swap(new_planes);
+		}
+	}
+
+	std::vector<std::size_t> tasks(faces.size());
+	std::size_t num_lines = 0, num_candidate_lines = 0;
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		tasks[i] = i;
+		num_lines += cutters[i].size();
+		num_candidate_lines += candidates[i].size();
+	}
+	std::size_t num_faces = replace_faces_by_cells(mesh, attribs, faces, tasks, inputs, outputs);
+
+	Logger::out("-") << "kinetic partition: " << num_rounds << " rounds, " << num_lines << " lines arranged (of "
+		<< num_candidate_lines << " crossing the faces), " << num_inserted << " points inserted into shared edges" << std::endl;
+	Logger::out("-") << "kinetic partition: " << num_active << " cells covered (of " << num_cells << "), "
+		<< num_collisions << " collisions. " << num_faces << " faces after merging ("
+		<< num_unmerged << " not simple, kept as cells)" << std::endl;
+}
+
+
+// compute the intersection of a plane triplet
+// returns true if the intersection exists (p returns the point)
+bool HypothesisGenerator::intersection_plane_triplet(const Plane3d* plane1, const Plane3d* plane2, const Plane3d* plane3, vec3& p, TripletCache* triplets) {
+	if (plane1 == nil || plane2 == nil || plane3 == nil) {
+		warn(triplets, "null planes");
+		return false;
+	}
+	if (plane1 == plane2 || plane2 == plane3) {
+		warn(triplets, "identical planes");
+		return false;
+	}
+
+	CGAL::Object obj = CGAL::intersection(to_cgal_plane(*plane1), to_cgal_plane(*plane2), to_cgal_plane(*plane3));
+
+	// pt is the intersection point of the 3 planes 
+	if (const Point3* pt = CGAL::object_cast<Point3>(&obj)) {
+		p = to_my_point(*pt);
+		return true;
+	}
+	else if (const Plane3* plane = CGAL::object_cast<Plane3>(&obj)) {
+		warn(triplets, "3 faces lie on the same supporting plane");
+		return false;
+	}
+	else if (const Line3* line = CGAL::object_cast<Line3>(&obj)) {
+		warn(triplets, "3 faces intersect at the same line");
+		return false;
+	}
+
+	return false;
+}
+
+
+void HypothesisGenerator::init_triplet_intersection(const Box3d& box) {
+	triplet_intersection_.clear();
+
+	if (supporting_planes_.size() > PlaneTripletTable::max_num_planes)
+		Logger::err("-") << "too many planes (" << supporting_planes_.size() << ")" << std::endl;
+
+	// a little larger than the box to tolerate the floating point errors of the points on its faces
+	float delta = box.radius() * 1e-3f;
+	triplet_box_.clear();
+	triplet_box_.add_point(vec3(box.x_min() - delta, box.y_min() - delta, box.z_min() - delta));
+	triplet_box_.add_point(vec3(box.x_max() + delta, box.y_max() + delta, box.z_max() + delta));
+
+	triplet_stats_ = TripletStatistics();
+}
+
+
+// the edges (given by their key halfedges) of the facets incident to 'v', including the edges incident 
+// to the vertices of these facets. These are all the edges whose collapsibility may change after 
+// collapsing an edge onto 'v'.
+static void collect_edges_around(Map::Vertex* v, std::set<Map::Halfedge*>& edges) {
+	VertexInHalfedgeCirculator cit(v);
+	for (; !cit->end(); ++cit) {
+		Map::Halfedge* h = cit->halfedge();
+		edges.insert(h->edge_key());
+		Map::Facet* faces[2] = { h->facet(), h->opposite()->facet() };
+		for (int i = 0; i < 2; ++i) {
+			if (faces[i] == nil)
+				continue;
+			FacetHalfedgeCirculator fit(faces[i]);
+			for (; !fit->end(); ++fit) {
+				VertexInHalfedgeCirculator vit(fit->halfedge()->vertex());
+				for (; !vit->end(); ++vit)
+					edges.insert(vit->halfedge()->edge_key());
+			}
+		}
+	}
+}
+
+
+void HypothesisGenerator::remove_degenerated_facets(Map* mesh) {
+	// You can't collect all the edges and then collapse them one by one, 
+	// because collapsing one edge affects other neighboring edges.
+	// Instead, the short edges are kept in a worklist ordered by their position in the mesh (so the 
+	// edges are processed in the same order as a full scan of the edges), and after each collapse
+	// only the edges around the remaining vertex are updated.
+	StopWatch w;
+
+	// collapse_edge() doesn't create halfedges, so their (initial) order in the mesh never changes
+	MapHalfedgeAttribute<int> order(mesh);
+	int idx = 0;
+	FOR_EACH_HALFEDGE(Map, mesh, it)
+		order[it] = idx++;
+
+	typedef std::set< std::pair<int, Map::Halfedge*> > Worklist;	// the key halfedges of the short edges
+	Worklist worklist;
+	FOR_EACH_EDGE(Map, mesh, it) {
+		if (distance2(it->vertex()->point(), it->prev()->vertex()->point()) < Method::snap_sqr_distance_threshold)
+			worklist.insert(std::make_pair(order[it], it));
+	}
+	std::size_t num_short = worklist.size();
+
+	MapEditor editor(mesh);
+	int count = 0;
+	while (!worklist.empty()) {
+		Map::Halfedge* h = worklist.begin()->second;
+		worklist.erase(worklist.begin());
+
+		// the edges incident to the two end points may be deleted by the collapse, so they are taken
+		// out of the worklist (and put back if the edge can't be collapsed).
+		Map::Vertex* dest = h->vertex();	// the collapse keeps h->vertex()
+		Map::Vertex* end_points[2] = { dest, h->opposite()->vertex() };
+		std::vector<Worklist::value_type> incident;
+		for (int i = 0; i < 2; ++i) {
+			VertexInHalfedgeCirculator cit(end_points[i]);
+			for (; !cit->end(); ++cit) {
+				Map::Halfedge* e = cit->halfedge()->edge_key();
+				Worklist::value_type entry(order[e], e);
+				if (worklist.erase(entry) > 0)
+					incident.push_back(entry);
+			}
+		}
+
+		if (!editor.collapse_edge(h)) {
+			worklist.insert(incident.begin(), incident.end());
+			continue;	// 'h' will be tested again if its neighborhood changes
+		}
+		++count;
+
+		std::set<Map::Halfedge*> edges;
+		collect_edges_around(dest, edges);
+		for (std::set<Map::Halfedge*>::iterator it = edges.begin(); it != edges.end(); ++it) {
+			Map::Halfedge* e = *it;
+			if (distance2(e->vertex()->point(), e->prev()->vertex()->point()) < Method::snap_sqr_distance_threshold)
+				worklist.insert(std::make_pair(order[e], e));
+		}
+	}
+
+	order.unbind();
+
+	if (count > 0) {
+		Logger::out("-") << count << " degenerate edges collapsed (" << num_short << " initially). "
+			<< w.elapsed() << " sec." << std::endl;
+	}
+}
+
+
+unsigned int HypothesisGenerator::add_supporting_plane(Plane3d* plane) {
+	unsigned int id = static_cast<unsigned int>(supporting_planes_.size());
+	supporting_planes_.push_back(plane);
+	plane_index_[plane] = id;
+	return id;
+}
+
+
+unsigned int HypothesisGenerator::plane_id(const Plane3d* plane) const {
+	auto pos = plane_index_.find(plane);
+	if (pos == plane_index_.end()) {
+		Logger::err("-") << "fatal error. unknown supporting plane" << std::endl;
+		return VertexSourcePlanes::invalid_id;
+	}
+	return pos->second;
+}
+
+
+bool HypothesisGenerator::query_intersection(unsigned int id1, unsigned int id2, unsigned int id3, vec3& p, TripletCache* triplets) {
+	if (id1 == id2 || id2 == id3 || id1 == id3) // not three different planes
+		return false;
+	if (id1 >= supporting_planes_.size() || id2 >= supporting_planes_.size() || id3 >= supporting_planes_.size())
+		return false;
+
+	PlaneTripletTable::Key key = PlaneTripletTable::key(id1, id2, id3);
+
+	// the data base is not modified while the worker threads use it, so it is read without locking
+	TripletStatistics& stats = triplets ? triplets->stats : triplet_stats_;
+	++stats.num_queries;
+
+	const PlaneTripletTable::Entry* entry = triplet_intersection_.find(key);
+	if (!entry && triplets)
+		entry = triplets->table.find(key);
+	if (entry) {
+		p = entry->point;
+		return entry->valid;
+	}
+
+	// not queried before: compute and store it in our data base (or the cache of the thread). The 
+	// planes are taken in the order of the key, so the point doesn't depend on the order of the query 
+	// (the intersection is not bit-stable under the permutation of the planes).
+	StopWatch w;
+	++stats.num_computed;
+	if (id1 > id2) std::swap(id1, id2);
+	if (id2 > id3) std::swap(id2, id3);
+	if (id1 > id2) std::swap(id1, id2);
+	bool valid = false;
+	if (intersection_plane_triplet(supporting_planes_[id1], supporting_planes_[id2], supporting_planes_[id3], p, triplets)) {
+		if (p.x >= triplet_box_.x_min() && p.x <= triplet_box_.x_max() &&
+			p.y >= triplet_box_.y_min() && p.y <= triplet_box_.y_max() &&
+			p.z >= triplet_box_.z_min() && p.z <= triplet_box_.z_max())
+			valid = true;
+		else
+			++stats.num_culled;
+	}
+	else
+		++stats.num_degenerate;
+
+	if (triplets)
+		triplets->table.insert(key, p, valid);
+	else {
+		triplet_intersection_.insert(key, p, valid);
+		triplet_stats_.memory = triplet_intersection_.memory();
+	}
+	stats.compute_time += w.elapsed();
+	return valid;
+}
+
+
+void HypothesisGenerator::merge_triplet_caches(const std::vector<TripletCache>& caches) {
+	std::map<std::string, std::size_t> warnings;
+	for (std::size_t i = 0; i < caches.size(); ++i) {
+		const TripletCache& cache = caches[i];
+		triplet_intersection_.merge(cache.table);
+		triplet_stats_.num_queries += cache.stats.num_queries;
+		triplet_stats_.num_computed += cache.stats.num_computed;
+		triplet_stats_.num_culled += cache.stats.num_culled;
+		triplet_stats_.num_degenerate += cache.stats.num_degenerate;
+		triplet_stats_.compute_time += cache.stats.compute_time;
+
+		std::map<std::string, std::size_t>::const_iterator it = cache.warnings.begin();
+		for (; it != cache.warnings.end(); ++it)
+			warnings[it->first] += it->second;
+	}
+	triplet_stats_.memory = triplet_intersection_.memory();
+
+	std::map<std::string, std::size_t>::const_iterator it = warnings.begin();
+	for (; it != warnings.end(); ++it)
+		Logger::warn("-") << it->first << " (" << it->second << " times)" << std::endl;
+}
+
+
+void HypothesisGenerator::warn(TripletCache* triplets, const std::string& message) {
+	if (triplets)
+		++triplets->warnings[message];
+	else
+		Logger::warn("-") << message << std::endl;
+}
+
+
+
+Map* HypothesisGenerator::generate() {
+	return generate_candidates(false);
+}
+
+
+Map* HypothesisGenerator::generate_kinetic() {
+	return generate_candidates(true);
+}
+
+
+Map* HypothesisGenerator::generate_candidates(bool kinetic) {
+	if (!pset_)
+		return nil;
+
+	if (pset_->groups().empty()) {
+		Logger::warn("-") << "planar segments do not exist" << std::endl;
+		return nil;
+	}
+
+	collect_valid_planes();
+
+	Box3d box = pset_->bbox();
+	delete bbox_mesh_;
+	bbox_mesh_ = construct_bbox_mesh(box, box.radius() * 0.05f);
+	Box3d triplet_box = bbox_mesh_->bbox();
+	kinetic_ = kinetic;
+
+	Map* mesh = compute_proxy_mesh(bbox_mesh_);
+	if (!mesh)
+		return nil;
+
+	check_source_planes(mesh);
+
+	CutAttributes attribs;
+	attribs.bind(mesh);
+
+	init_triplet_intersection(triplet_box);
+	if (kinetic)
+		kinetic_partition(mesh, attribs, resolved_num_threads());
+	else
+		pairwise_cut(mesh, attribs);
+	check_source_planes(mesh);
+
+	remove_degenerated_facets(mesh);
+	check_source_planes(mesh);
+
+	attribs.unbind();
+
+	Logger::out("-") << "candidate faces: " << mesh->size_of_facets()
+		<< (kinetic ? " (kinetic)" : "") << std::endl;
+
+	const TripletStatistics& stats = triplet_stats_;
+	std::size_t num_planes = supporting_planes_.size();
+	double num_triplets = num_planes * (num_planes - 1.0) * (num_planes - 2.0) / 6.0;
+	Logger::out("-") << "plane triplets: " << stats.num_computed << " computed (of " << num_triplets << "), "
+		<< stats.num_culled << " outside the bbox, " << stats.num_degenerate << " degenerate. "
+		<< stats.num_queries << " queries, hit rate: " 
+		<< (stats.num_queries > 0 ? 100.0 * (stats.num_queries - stats.num_computed) / stats.num_queries : 0.0) << "%. "
+		<< stats.memory / 1024 << " KB, " << stats.compute_time << " sec." << std::endl;
+
+	return mesh;
+}
+
+
+bool HypothesisGenerator::update(Map* mesh, const PlaneDelta& delta, bool use_conficence /* = false */) {
+	if (!pset_ || !mesh)
+		return false;
+
+	if (!bbox_mesh_ || kinetic_) {
+		Logger::warn("-") << "incremental update is supported only for the candidate faces of generate()" << std::endl;
+		return false;
+	}
 
+	StopWatch w;
+	CutAttributes attribs;
+	attribs.bind(mesh);
+
+	// the planes of the removed and modified segments are retired. They are kept in supporting_planes_ 
+	// (so the ids of the other planes don't change), but no face will lie on them any more.
+	std::set<unsigned int> retired;
+	std::vector<VertexGroup*> retiring(delta.removed);
+	retiring.insert(retiring.end(), delta.modified.begin(), delta.modified.end());
+	for (std::size_t i = 0; i < retiring.size(); ++i) {
+		std::map<VertexGroup*, Plane3d*>::const_iterator pos = vertex_group_plane_.find(retiring[i]);
+		if (pos != vertex_group_plane_.end())
+			retired.insert(plane_id(pos->second));
+		else
+			Logger::warn("-") << "unknown segment ignored" << std::endl;
+	}
+
+	// The faces of the retired planes and of the planes they used to cross (i.e., having an edge or a 
+	// vertex on a retired plane) are rebuilt from their proxy faces.
+	std::set<Plane3d*> rebuilt_planes;
+	FOR_EACH_HALFEDGE(Map, mesh, it) {
+		if (it->facet() == nil)
+			continue;
+		const EdgeSourcePlanes& edge_planes = attribs.edge_source_planes[it];
+		const VertexSourcePlanes& vertex_planes = attribs.vertex_source_planes[it->vertex()];
+		bool crossed = false;
+		for (std::size_t k = 0; k < edge_planes.size(); ++k)
+			crossed = crossed || retired.find(edge_planes[k]) != retired.end();
+		for (std::size_t k = 0; k < vertex_planes.size(); ++k)
+			crossed = crossed || retired.find(vertex_planes[k]) != retired.end();
+		if (crossed)
+			rebuilt_planes.insert(attribs.supporting_plane[it->facet()]);
+	}
+
+	std::vector<MapTypes::Facet*> obsolete_faces;
+	FOR_EACH_FACET(Map, mesh, it) {
+		if (rebuilt_planes.find(attribs.supporting_plane[it]) != rebuilt_planes.end())
+			obsolete_faces.push_back(it);
+	}
+	MapEditor editor(mesh);
+	for (std::size_t i = 0; i < obsolete_faces.size(); ++i)
+		editor.erase_facet(obsolete_faces[i]->halfedge());
+
+	// update the segments and their planes
+	for (std::size_t i = 0; i < delta.removed.size(); ++i) {
+		VertexGroup* g = delta.removed[i];
+		if (vertex_group_plane_.erase(g) == 0)
+			continue;
+		for (std::size_t j = 0; j < plane_segments_.size(); ++j) {
+			if (static_cast<VertexGroup*>(plane_segments_[j]) == g) {
+				plane_segments_.erase(plane_segments_.begin() + j);
+				break;
+			}
+		}
+	}
+
+	std::set<Plane3d*> new_planes;
+	for (std::size_t i = 0; i < delta.modified.size(); ++i) {
+		VertexGroup* g = delta.modified[i];
+		if (vertex_group_plane_.find(g) == vertex_group_plane_.end())
+			continue;
+		g->invalidate_moments();	// its points may have been changed in place
+		pset_->fit_plane(g);
+		Plane3d* plane = new Plane3d(g->plane());
+		add_supporting_plane(plane);
+		vertex_group_plane_[g] = plane;
+		new_planes.insert(plane);
+	}
+	for (std::size_t i = 0; i < delta.added.size(); ++i) {
+		VertexGroup* g = delta.added[i];
+		if (vertex_group_plane_.find(g) != vertex_group_plane_.end()) {
+			Logger::warn("-") << "segment added twice ignored" << std::endl;
+			continue;
+		}
+		pset_->fit_plane(g);
+		plane_segments_.push_back(g);
+		Plane3d* plane = new Plane3d(g->plane());
+		add_supporting_plane(plane);
+		vertex_group_plane_[g] = plane;
+		new_planes.insert(plane);
+	}
+
+	// the proxy faces of the new planes and of the planes to be rebuilt
+	std::vector<VertexGroup*> segments;
+	for (std::size_t i = 0; i < plane_segments_.size(); ++i) {
+		VertexGroup* g = plane_segments_[i];
+		Plane3d* plane = vertex_group_plane_[g];
+		if (new_planes.find(plane) != new_planes.end() || rebuilt_planes.find(plane) != rebuilt_planes.end()) {
+			segments.push_back(g);
+			rebuilt_planes.insert(plane);
+		}
+	}
+	{
+		MapBuilder builder(mesh);
+		builder.begin_surface();
+		int idx = 0;
+		add_proxy_faces(bbox_mesh_, segments, builder, idx);
+		builder.end_surface();
+	}
+	complete_proxy_source_planes(mesh);
+
+	// The proxy faces are cut by all the planes crossing them (as in generate()), and the other faces 
+	// only by the new planes (the others have cut them already).
+	std::vector<MapTypes::Facet*> faces;
+	FOR_EACH_FACET(Map, mesh, it)
+		faces.push_back(it);
+	float padding = static_cast<float>(std::sqrt(Method::snap_sqr_distance_threshold)) + mesh->bbox().radius() * 1e-6f;
+	FacetBoxTree tree(faces, padding);
+
+	std::vector<MapTypes::Facet*> proxy_faces;
+	std::vector< std::set<Plane3d*> > proxy_cutters;
+	std::vector< std::set<Plane3d*> > face_cutters(faces.size());	// the other faces crossed by new planes
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		MapTypes::Facet* f = faces[i];
+		Plane3d* plane = attribs.supporting_plane[f];
+		if (rebuilt_planes.find(plane) == rebuilt_planes.end())
+			continue;
+		proxy_faces.push_back(f);
+		proxy_cutters.push_back(collect_cutting_planes(f, faces, tree, attribs));
+		if (new_planes.find(plane) == new_planes.end())
+			continue;
+
+		std::vector<std::size_t> candidates;
+		tree.facets_intersecting(*plane, candidates);
+		for (std::size_t j = 0; j < candidates.size(); ++j) {
+			MapTypes::Facet* g = faces[candidates[j]];
+			if (rebuilt_planes.find(attribs.supporting_plane[g]) == rebuilt_planes.end() && do_intersect(g, plane, attribs))
+				face_cutters[candidates[j]].insert(plane);
+		}
+	}
+
+	// The other faces are connected to their neighbors on the same plane, so they are cut in place.
+	std::set<Plane3d*> cut_planes;
+	for (std::size_t i = 0; i < faces.size(); ++i) {
+		if (face_cutters[i].empty())
+			continue;
+		cut_planes.insert(attribs.supporting_plane[faces[i]]);
+		cut_face(faces[i], face_cutters[i], mesh, attribs);
+	}
+	cut_proxy_faces(mesh, attribs, proxy_faces, proxy_cutters);
+	check_source_planes(mesh);
+
+	remove_degenerated_facets(mesh);
+	check_source_planes(mesh);
+
+	Logger::out("-") << "candidate faces updated: " << retired.size() << " planes retired, " << new_planes.size() << " new, " 
+		<< segments.size() - new_planes.size() << " rebuilt, " << cut_planes.size() << " cut by the new planes. "
+		<< mesh->size_of_facets() << " faces. " << w.elapsed() << " sec." << std::endl;
+
+	// If the point confidences have never been computed, neither have the ones of the other faces, so
+	// the confidences of all the faces are computed.
+	bool all_faces = (avg_spacing_ <= 0);
+	std::vector<MapTypes::Facet*> facets;
+	FOR_EACH_FACET(Map, mesh, it) {
+		Plane3d* plane = attribs.supporting_plane[it];
+		if (all_faces || rebuilt_planes.find(plane) != rebuilt_planes.end() || cut_planes.find(plane) != cut_planes.end())
+			facets.push_back(it);
+	}
+	attribs.unbind();
+
+	// the point confidences are not available yet (or not for this point set, e.g., after loading the 
+	// candidate faces)
+	std::size_t num_points = 0;
+	if (all_faces || pset_->planar_qualities().size() != pset_->points().size())
+		num_points = pset_->num_points();
+	ProgressLogger progress(num_points + facets.size());
+	if (num_points > 0)
+		avg_spacing_ = compute_point_confidences(pset_, 6, 16, 25, &progress);
+	compute_facet_confidences(mesh, facets, use_conficence, progress, num_points);
+
+	return true;
+}
+
+
+void HypothesisGenerator::clear() {
+	for (std::size_t i = 0; i < supporting_planes_.size(); ++i)
+		delete supporting_planes_[i];
+	supporting_planes_.clear();
+	plane_index_.clear();
+
+	delete bbox_mesh_;
+	bbox_mesh_ = nil;
+
+	triplet_intersection_.clear();
+}
+
+
+
+
+float HypothesisGenerator::compute_point_confidences(PointSet* pset, int s1 /* = 6 */, int s2 /* = 16 */, int s3 /* = 32 */, ProgressLogger* progress) {
+	std::vector<vec3>& points = pset->points();
+	std::vector<float>& planar_qualities = pset->planar_qualities();
+
+	if (planar_qualities.size() != points.size())
+		planar_qualities.resize(points.size());
+
+	KdTreeSearch_var kdtree = new KdTreeSearch;
+	kdtree->begin();
+	kdtree->add_vertex_set(pset);
+	kdtree->end();
+
+	// The neighborhoods of the three scales are the prefixes of the largest one. So a single query 
+	// is issued for each point, and the moments of the neighbors are accumulated incrementally.
+	const int neighbor_size[3] = { s1, s2, s3 };
+	const unsigned int max_size = static_cast<unsigned int>(std::max(s1, std::max(s2, s3)));
+
+	// The points are processed in chunks. The average spacing is first summed up within each chunk 
+	// and then over the chunks (in order), so the result doesn't depend on the number of threads.
+	const std::size_t chunk_size = 4096;
+	const std::size_t num_chunks = (points.size() + chunk_size - 1) / chunk_size;
+	std::vector<double> chunk_spacing(num_chunks, 0.0);
+
+	std::atomic<std::size_t> next_chunk(0);
+	std::atomic<std::size_t> num_done(0);
+	auto worker = [&](bool report_progress) {
+		KdTreeSearch::Workspace workspace;
+		std::vector<unsigned int> neighbors;
+		std::vector<double> sqr_distances;
+		double eigen_values[3][3];
+
+		for (std::size_t c = next_chunk++; c < num_chunks; c = next_chunk++) {
+			std::size_t end = std::min(points.size(), (c + 1) * chunk_size);
+			for (std::size_t i = c * chunk_size; i < end; ++i) {
+				neighbors.clear();
+				kdtree->find_closest_K_points(points[i], max_size, neighbors, sqr_distances, workspace);
+
+				// the trivial values (i.e., no confidence) in case not enough neighbors are found
+				for (int j = 0; j < 3; ++j)
+					eigen_values[j][0] = eigen_values[j][1] = eigen_values[j][2] = 1.0;
+
+				PointMoments3d moments;
+				double avg = 0;
+				for (unsigned int k = 0; k < neighbors.size(); ++k) {
+					moments.add_point(points[neighbors[k]]);
+					if (k < static_cast<unsigned int>(s1))
+						avg += std::sqrt(sqr_distances[k]);
+
+					for (int j = 0; j < 3; ++j) {
+						if (k + 1 != static_cast<unsigned int>(neighbor_size[j]))
+							continue;
+						PrincipalAxes3d pca;
+						pca.compute(moments);
+						for (int m = 0; m < 3; ++m)
+							eigen_values[j][m] = pca.eigen_value(3 - m - 1); // eigen values are sorted in descending order
+
+						assert(eigen_values[j][0] <= eigen_values[j][1] && eigen_values[j][1] <= eigen_values[j][2]);
+					}
+				}
+				chunk_spacing[c] += (avg / s1);
+
+				double conf = 0.0;
+				for (int j = 0; j < 3; ++j) {
+					conf += (1 - 3.0 * eigen_values[j][0] / (eigen_values[j][0] + eigen_values[j][1] + eigen_values[j][2])) * (eigen_values[j][1] / eigen_values[j][2]);
+				}
+				conf /= 3.0;
+				planar_qualities[i] = static_cast<float>(conf);
+			}
+
+			num_done += (end - c * chunk_size);
+			if (progress && report_progress)
+				progress->notify(num_done);
+		}
+	};
+
+	int num_threads = std::min(resolved_num_threads(), static_cast<int>(std::max<std::size_t>(num_chunks, 1)));
+	std::vector<std::thread> threads;
+	for (int i = 1; i < num_threads; ++i)
+		threads.push_back(std::thread(worker, false));
+	worker(true);
+	for (std::size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	if (progress)
+		progress->notify(points.size());
+
+	double total = 0;
+	for (std::size_t c = 0; c < num_chunks; ++c)
+		total += chunk_spacing[c];
+	return static_cast<float>(total / points.size());
+}
+
+
+void HypothesisGenerator::compute_confidences(Map* mesh, bool use_conficence /* = false */) {
 	StopWatch w;
 	Logger::out("-") << "computing point confidences..." << std::endl;
     ProgressLogger progress(pset_->num_points() + mesh->size_of_facets());
-	double avg_spacing = compute_point_confidences(pset_, 6, 16, 25, &progress);
+	avg_spacing_ = compute_point_confidences(pset_, 6, 16, 25, &progress);
+	Logger::out("-") << "done. avg spacing: " << avg_spacing_ << ". " << w.elapsed() << " sec." << std::endl;
+
+	std::vector<Map::Facet*> facets;
+	FOR_EACH_FACET(Map, mesh, it)
+		facets.push_back(it);
+	compute_facet_confidences(mesh, facets, use_conficence, progress, pset_->num_points());
+}
+
+
+void HypothesisGenerator::compute_facet_confidences(
+	Map* mesh, 
+	const std::vector<MapTypes::Facet*>& facets, 
+	bool use_conficence, 
+	ProgressLogger& progress, 
+	std::size_t num_done_before
+) 
+{
+	facet_attrib_supporting_vertex_group_.bind(mesh, Method::facet_attrib_supporting_vertex_group);
+
+	StopWatch w;
+	double avg_spacing = avg_spacing_;
 	float radius = static_cast<float>(avg_spacing)* 5.0f;
-	Logger::out("-") << "done. avg spacing: " << avg_spacing << ". " << w.elapsed() << " sec." << std::endl;
 
 	std::vector<VertexGroup::Ptr>& groups = pset_->groups();
 	const std::vector<vec3>& pts = pset_->points();
@@ -1057,12 +2929,99 @@ void HypothesisGenerator::compute_confidences(Map* mesh, bool use_conficence /*
 	MapFacetAttribute<double>	facet_attrib_facet_area(mesh, Method::facet_attrib_facet_area);
 	MapFacetAttribute<double>	facet_attrib_covered_area(mesh, Method::facet_attrib_covered_area);
 
-	Logger::out("-") << "computing face confidences..." << std::endl;
+	Logger::out("-") << "computing face confidences (" << (coverage_estimator_ == RASTER ? "raster" : "alpha shape") << ")..." << std::endl;
 	w.start();
-	FOR_EACH_FACET(Map, mesh, it) {
-		Map::Facet* f = it;
 
-		double face_area = Geom::facet_area(f);
+	std::vector<VertexGroup*> facet_groups;
+	for (std::size_t i = 0; i < facets.size(); ++i)
+		facet_groups.push_back(facet_attrib_supporting_vertex_group_[facets[i]]);
+
+	struct FacetQuality {
+		double	supporting_point_num;
+		double	facet_area;
+		double	covered_area;
+	};
+	std::vector<FacetQuality> qualities(facets.size());
+
+	std::vector< std::vector<unsigned int> > facet_points;
+	std::vector<float> facet_counts;
+	assign_points_to_facets(facets, facet_groups, max_dist, facet_points, facet_counts);
+
+	// the facets on each plane share a single alpha shape (or occupancy grid)
+	std::map<VertexGroup*, std::vector<std::size_t> > group_facets;
+	for (std::size_t i = 0; i < facets.size(); ++i)
+		group_facets[facet_groups[i]].push_back(i);
+	std::vector< std::pair<VertexGroup*, std::vector<std::size_t> > > tasks(group_facets.begin(), group_facets.end());
+
+	// The planes are evaluated independently (and concurrently if multiple threads are used). The 
+	// results are written to the attributes afterwards, so they don't depend on the number of threads.
+	const std::size_t num_points = num_done_before;
+	std::atomic<std::size_t> next_task(0);
+	std::atomic<std::size_t> num_done(0);
+	auto worker = [&](bool report_progress) {
+		for (std::size_t t = next_task++; t < tasks.size(); t = next_task++) {
+			VertexGroup* g = tasks[t].first;
+			const std::vector<std::size_t>& ids = tasks[t].second;
+
+			std::vector<unsigned int> plane_points;
+			std::vector<Polygon2d> regions(ids.size());
+			for (std::size_t k = 0; k < ids.size(); ++k) {
+				std::size_t i = ids[k];
+				FacetQuality& quality = qualities[i];
+				quality.facet_area = Geom::facet_area(facets[i]);
+				quality.covered_area = 0;
+				if (quality.facet_area < 1e-16) // the degenerate facets are reported later
+					continue;
+
+				const std::vector<unsigned int>& points = facet_points[i];
+				if (use_conficence)
+					quality.supporting_point_num = facet_counts[i];
+				else
+					quality.supporting_point_num = static_cast<double>(points.size());
+
+				// as before, a facet supported by very few points is not considered covered
+				if (g && points.size() >= 10) {
+					const Plane3d& plane = g->plane();
+					regions[k] = Geom::to_2d(plane.point(), plane.base1(), plane.base2(), Geom::facet_polygon(facets[i]));
+					plane_points.insert(plane_points.end(), points.begin(), points.end());
+				}
+			}
+
+			if (g && !plane_points.empty()) {
+				std::sort(plane_points.begin(), plane_points.end());
+				plane_points.erase(std::unique(plane_points.begin(), plane_points.end()), plane_points.end());
+
+				std::vector<double> areas;
+				if (coverage_estimator_ == RASTER)
+					RasterCoverage::covered_areas(pset_, plane_points, g->plane(), static_cast<float>(avg_spacing), radius, regions, areas);
+				else
+					AlphaShapeMesh::covered_areas(pset_, plane_points, g->plane(), radius, regions, areas);
+				for (std::size_t k = 0; k < ids.size(); ++k) {
+					if (!regions[k].empty())
+						qualities[ids[k]].covered_area = areas[k];
+				}
+			}
+
+			num_done += ids.size();
+			if (report_progress)
+				progress.notify(num_points + num_done);
+		}
+	};
+
+	int num_threads = std::min(resolved_num_threads(), static_cast<int>(std::max<std::size_t>(tasks.size(), 1)));
+	std::vector<std::thread> threads;
+	for (int i = 1; i < num_threads; ++i)
+		threads.push_back(std::thread(worker, false));
+	worker(true);
+	for (std::size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	progress.notify(num_points + facets.size());
+
+	for (std::size_t i = 0; i < facets.size(); ++i) {
+		Map::Facet* f = facets[i];
+		const FacetQuality& quality = qualities[i];
+
+		double face_area = quality.facet_area;
 		if (face_area < 1e-16) {
 			Logger::err("-") << "degenerate facet with area: " << face_area << std::endl;
 			FacetHalfedgeCirculator cir(f);
@@ -1073,30 +3032,14 @@ void HypothesisGenerator::compute_confidences(Map* mesh, bool use_conficence /*
 			continue;
 		}
 
-		VertexGroup* g = facet_attrib_supporting_vertex_group_[f];
-
-		std::vector<unsigned int> points;
-		double num = facet_points_projected_in(pset_, g, f, max_dist, points);
-		if (use_conficence)
-			facet_attrib_supporting_point_num[f] = num;
-		else
-			facet_attrib_supporting_point_num[f] = static_cast<double>(points.size());
-
+		facet_attrib_supporting_point_num[f] = quality.supporting_point_num;
 		facet_attrib_facet_area[f] = face_area;
+		facet_attrib_covered_area[f] = quality.covered_area;
 
-		Map::Ptr alpha_mesh = AlphaShapeMesh::apply(pset_, points, g->plane(), radius);
-		double covered_area = 0;
-		if (alpha_mesh) {
-			FOR_EACH_FACET(Map, alpha_mesh, it)
-				covered_area += Geom::triangle_area(it);
-		}
-		facet_attrib_covered_area[f] = covered_area;
-
-		if (covered_area > face_area) {
+		if (quality.covered_area > face_area) {
 			// this may not be an error (floating point precision limit)
 			facet_attrib_covered_area[f] = face_area;
 		}
-		progress.next();
 	}
 
 	facet_attrib_supporting_vertex_group_.unbind();
@@ -1105,34 +3048,72 @@ void HypothesisGenerator::compute_confidences(Map* mesh, bool use_conficence /*
 }
 
 
-float HypothesisGenerator::facet_points_projected_in(PointSet* pset, VertexGroup* g, MapTypes::Facet* f, float max_dist, std::vector<unsigned int>& points) {
-	const Plane3d& plane = g->plane();
-	const vec3& orig = plane.point();
-	const vec3& base1 = plane.base1();
-	const vec3& base2 = plane.base2();
-
-	const Polygon3d& plg3d = Geom::facet_polygon(f);
-	const Polygon2d& plg2d = Geom::to_2d(orig, base1, base2, plg3d);
-	const std::vector<vec3>& pts = pset->points();
-	const std::vector<float>& confidences = pset->planar_qualities();
-
-	points.clear();
-	float epsilon = max_dist * 0.5f;// considering noise and outliers
-	float count = 0.0f;
-	for (int i = 0; i < g->size(); ++i) {
-		unsigned int idx = g->at(i);
-		const vec3& p = pts[idx];
-		const vec2& q = Geom::to_2d(orig, base1, base2, p);
-		if (Geom::point_is_in_polygon(plg2d, q)) {
-			points.push_back(idx);
-			float dist = std::sqrt(plane.squared_ditance(p));
-			if (dist < epsilon) { // in case of numerical issues (floating point precision)
-				count += (1 - dist / epsilon) * confidences[idx];
-			}
-		}
+void HypothesisGenerator::assign_points_to_facets(
+	const std::vector<MapTypes::Facet*>& facets,
+	const std::vector<VertexGroup*>& groups,
+	float max_dist,
+	std::vector< std::vector<unsigned int> >& points,
+	std::vector<float>& counts)
+{
+	points.assign(facets.size(), std::vector<unsigned int>());
+	counts.assign(facets.size(), 0.0f);
+
+	// the facets on each plane
+	std::map<VertexGroup*, std::vector<std::size_t> > group_facets;
+	for (std::size_t i = 0; i < facets.size(); ++i) {
+		if (groups[i])
+			group_facets[groups[i]].push_back(i);
 	}
+	std::vector< std::pair<VertexGroup*, std::vector<std::size_t> > > tasks(group_facets.begin(), group_facets.end());
 
-	return count;
+	const std::vector<vec3>& pts = pset_->points();
+	const std::vector<float>& confidences = pset_->planar_qualities();
+	const float epsilon = max_dist * 0.5f;// considering noise and outliers
+
+	// the planes are independent, and the facets of different planes are written by different threads
+	std::atomic<std::size_t> next_task(0);
+	auto worker = [&]() {
+		std::vector<int> containing;
+		for (std::size_t t = next_task++; t < tasks.size(); t = next_task++) {
+			VertexGroup* g = tasks[t].first;
+			const std::vector<std::size_t>& ids = tasks[t].second;
+
+			const Plane3d& plane = g->plane();
+			const vec3& orig = plane.point();
+			const vec3& base1 = plane.base1();
+			const vec3& base2 = plane.base2();
+
+			std::vector<Polygon2d> polygons(ids.size());
+			for (std::size_t i = 0; i < ids.size(); ++i)
+				polygons[i] = Geom::to_2d(orig, base1, base2, Geom::facet_polygon(facets[ids[i]]));
+			PolygonGrid2d grid(polygons);
+
+			for (std::size_t i = 0; i < g->size(); ++i) {
+				unsigned int idx = g->at(i);
+				const vec3& p = pts[idx];
+				grid.locate(Geom::to_2d(orig, base1, base2, p), containing);
+				if (containing.empty())
+					continue;
+
+				float dist = std::sqrt(plane.squared_ditance(p));
+				for (std::size_t j = 0; j < containing.size(); ++j) {
+					std::size_t id = ids[containing[j]];
+					points[id].push_back(idx);
+					if (dist < epsilon) { // in case of numerical issues (floating point precision)
+						counts[id] += (1 - dist / epsilon) * confidences[idx];
+					}
+				}
+			}
+		}
+	};
+
+	int num_threads = std::min(resolved_num_threads(), static_cast<int>(std::max<std::size_t>(tasks.size(), 1)));
+	std::vector<std::thread> threads;
+	for (int i = 1; i < num_threads; ++i)
+		threads.push_back(std::thread(worker));
+	worker();
+	for (std::size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
 }
 
 
@@ -1140,66 +3121,65 @@ float HypothesisGenerator::facet_points_projected_in(PointSet* pset, VertexGroup
 HypothesisGenerator::Adjacency HypothesisGenerator::extract_adjacency(Map* mesh) {
 	vertex_source_planes_.bind(mesh, "VertexSourcePlanes");
 
-	// an edge is denoted by its two end points
-	typedef typename std::map< vec3*, std::set<MapTypes::Halfedge*> >	Edge_map;
-	typedef typename std::map< vec3*, Edge_map >						Face_pool;
-	Face_pool face_pool;
+	// an edge is denoted by its two end points, and an end point is identified by its three source 
+	// planes, which are packed into a single key. Sorting the halfedges by their edges groups them into 
+	// super edges (in the same order as the source planes of the end points).
+	struct EdgeRecord {
+		PlaneTripletTable::Key	s;
+		PlaneTripletTable::Key	t;
+		MapTypes::Halfedge*		h;
+
+		bool operator<(const EdgeRecord& rhs) const {
+			if (s != rhs.s) return s < rhs.s;
+			if (t != rhs.t) return t < rhs.t;
+			return std::less<MapTypes::Halfedge*>()(h, rhs.h);
+		}
+		bool same_edge(const EdgeRecord& rhs) const { return s == rhs.s && t == rhs.t; }
+	};
 
+	std::vector<EdgeRecord> records;
+	records.reserve(mesh->size_of_halfedges());
 	FOR_EACH_HALFEDGE(Map, mesh, h) {
 		if (h->facet() == 0)
 			continue;
 
-		Map::Vertex* sd = h->opposite()->vertex();
-		Map::Vertex* td = h->vertex();
-
-		std::set<Plane3d*>& set_s = vertex_source_planes_[sd];
-		std::set<Plane3d*>& set_t = vertex_source_planes_[td];
-		CGAL_assertion(set_s.size() == 3);
-		CGAL_assertion(set_t.size() == 3);
-
-		std::vector<Plane3d*> s_planes(set_s.begin(), set_s.end());
-		CGAL_assertion(s_planes[0] < s_planes[1]);
-		CGAL_assertion(s_planes[1] < s_planes[2]);
-		vec3* s = triplet_intersection_[s_planes[0]][s_planes[1]][s_planes[2]];
-
-		std::vector<Plane3d*> t_planes(set_t.begin(), set_t.end());
-		CGAL_assertion(t_planes[0] < t_planes[1]);
-		CGAL_assertion(t_planes[1] < t_planes[2]);
-		vec3* t = triplet_intersection_[t_planes[0]][t_planes[1]][t_planes[2]];
-
-		if (s > t)
-			std::swap(s, t);
-		face_pool[s][t].insert(h);
+		const VertexSourcePlanes& s = vertex_source_planes_[h->opposite()->vertex()];
+		const VertexSourcePlanes& t = vertex_source_planes_[h->vertex()];
+		CGAL_assertion(s.size() == 3);
+		CGAL_assertion(t.size() == 3);
+
+		EdgeRecord r;
+		r.s = PlaneTripletTable::key(s[0], s[1], s[2]);
+		r.t = PlaneTripletTable::key(t[0], t[1], t[2]);
+		if (r.t < r.s)
+			std::swap(r.s, r.t);
+		r.h = h;
+		records.push_back(r);
 	}
+	std::sort(records.begin(), records.end());
 
-#ifdef DISPLAY_ADJACENCY_STATISTICS
-	std::map<std::size_t, std::size_t>   num_each_sized_fans;
-	for (std::size_t i = 1; i < 20; ++i)
-		num_each_sized_fans[i] = 0;
-#endif
+	vertex_source_planes_.unbind();
 
 	Adjacency fans;
-	Face_pool::const_iterator it = face_pool.begin();
-	for (; it != face_pool.end(); ++it) {
-		const vec3* s = it->first;
-		const Edge_map& tmp = it->second;
-		Edge_map::const_iterator cur = tmp.begin();
-		for (; cur != tmp.end(); ++cur) {
-			const vec3* t = cur->first;
-			const std::set<Map::Halfedge*>& faces = cur->second;
-			SuperEdge fan;
-			fan.s = s;
-			fan.t = t;
-			fan.insert(fan.end(), faces.begin(), faces.end());
-			fans.push_back(fan);
-
-#ifdef DISPLAY_ADJACENCY_STATISTICS
-			++num_each_sized_fans[fan.size()];
-#endif
-		}
+	fans.kinetic_ = kinetic_;
+	fans.halfedges_.reserve(records.size());
+	for (std::size_t i = 0; i < records.size(); ) {
+		// all the halfedges share the same end points (up to the orientation)
+		Map::Halfedge* h = records[i].h;
+		fans.end_points_.push_back(h->opposite()->vertex()->point());
+		fans.end_points_.push_back(h->vertex()->point());
+
+		std::size_t j = i;
+		for (; j < records.size() && records[j].same_edge(records[i]); ++j)
+			fans.halfedges_.push_back(records[j].h);
+		fans.offsets_.push_back(fans.halfedges_.size());
+		i = j;
 	}
 
 #ifdef DISPLAY_ADJACENCY_STATISTICS
+	std::map<std::size_t, std::size_t>   num_each_sized_fans;
+	for (std::size_t i = 0; i < fans.size(); ++i)
+		++num_each_sized_fans[fans[i].size()];
 	std::map<std::size_t, std::size_t>::iterator pos = num_each_sized_fans.begin();
 	for (; pos != num_each_sized_fans.end(); ++pos) {
 		if (pos->second > 0)
@@ -1207,8 +3187,6 @@ HypothesisGenerator::Adjacency HypothesisGenerator::extract_adjacency(Map* mesh)
 	}
 #endif
 
-	vertex_source_planes_.unbind();
-
 	return fans;
 }
 
@@ -1221,3 +3199,448 @@ bool HypothesisGenerator::ready_for_optimization(Map* mesh) const {
 		MapFacetAttribute<double>::is_defined(mesh, Method::facet_attrib_covered_area)
 		);
 }
+
+
+namespace {
+
+	const char	checkpoint_magic[4] = { 'P', 'F', 'C', 'K' };
+	const int	checkpoint_version = 1;
+
+	template <typename T>
+	void write_value(std::ostream& output, const T& value) {
+		output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	void read_value(std::istream& input, T& value) {
+		input.read(reinterpret_cast<char*>(&value), sizeof(T));
+	}
+
+	void write_plane(std::ostream& output, const Plane3d& plane) {
+		float coeff[4] = { plane.a(), plane.b(), plane.c(), plane.d() };
+		output.write(reinterpret_cast<const char*>(coeff), sizeof(coeff));
+	}
+
+	Plane3d read_plane(std::istream& input) {
+		float coeff[4];
+		input.read(reinterpret_cast<char*>(coeff), sizeof(coeff));
+		return Plane3d(coeff[0], coeff[1], coeff[2], coeff[3]);
+	}
+
+	// a facet as it is stored in a checkpoint
+	struct CheckpointFacet {
+		std::vector<int>			vertices;
+		std::vector<unsigned int>	edge_planes;
+		unsigned int				plane;
+		int							group;
+		float						color[4];
+		double						point_num, area, covered;
+	};
+
+	// builds the candidate faces of a checkpoint on the 'planes' (indexed by their ids) and the 'groups'. 
+	// Returns nil if the builder rejects a facet (e.g., if it has duplicated vertices).
+	Map* build_checkpoint_mesh(
+		const std::vector<vec3>& points,
+		const std::vector<VertexSourcePlanes>& point_planes,
+		const std::vector<CheckpointFacet>& facets,
+		const std::vector<Plane3d*>& planes,
+		const std::vector<VertexGroup::Ptr>& groups
+	)
+	{
+		Map* mesh = new Map;
+		bool rejected = false;
+		{
+			MapVertexAttribute<VertexSourcePlanes>	vertex_source_planes(mesh, "VertexSourcePlanes");
+			MapHalfedgeAttribute<EdgeSourcePlanes>	edge_source_planes(mesh, "EdgeSourcePlanes");
+			MapFacetAttribute<Plane3d*>				supporting_plane(mesh, "FacetSupportingPlane");
+			MapFacetAttribute<VertexGroup*>			supporting_group(mesh, Method::facet_attrib_supporting_vertex_group);
+			MapFacetAttribute<Color>				color(mesh, "color");
+			MapFacetAttribute<double>				supporting_point_num(mesh, Method::facet_attrib_supporting_point_num);
+			MapFacetAttribute<double>				facet_area(mesh, Method::facet_attrib_facet_area);
+			MapFacetAttribute<double>				covered_area(mesh, Method::facet_attrib_covered_area);
+
+			MapBuilder builder(mesh);
+			builder.begin_surface();
+			for (std::size_t i = 0; i < points.size(); ++i) {
+				builder.add_vertex(points[i]);
+				vertex_source_planes[builder.current_vertex()] = point_planes[i];
+			}
+
+			const int num_groups = static_cast<int>(groups.size());
+			for (std::size_t i = 0; i < facets.size(); ++i) {
+				const CheckpointFacet& r = facets[i];
+				const std::vector<int>& ids = r.vertices;
+				const int num = static_cast<int>(ids.size());
+				builder.begin_facet();
+				for (int j = 0; j < num; ++j)
+					builder.add_vertex_to_facet(ids[j]);
+				builder.end_facet();
+
+				// the builder ignores an invalid facet, and then the current facet is the previous one
+				if (mesh->size_of_facets() != static_cast<int>(i) + 1) {
+					rejected = true;
+					break;
+				}
+
+				Map::Facet* f = builder.current_facet();
+				supporting_plane[f] = planes[r.plane];
+				supporting_group[f] = (r.group >= 0 && r.group < num_groups) ? static_cast<VertexGroup*>(groups[r.group]) : nil;
+				color[f] = Color(r.color[0], r.color[1], r.color[2], r.color[3]);
+				supporting_point_num[f] = r.point_num;
+				facet_area[f] = r.area;
+				covered_area[f] = r.covered;
+
+				// the circulation may start at any halfedge of the facet, which is located by its vertex (by the
+				// position, because the builder may have split the vertex)
+				int j = 0;
+				for (int k = 0; k < num; ++k) {
+					if (distance2(points[ids[k]], f->halfedge()->vertex()->point()) == 0) {
+						j = k;
+						break;
+					}
+				}
+				FacetHalfedgeCirculator cir(f);
+				for (; !cir->end(); ++cir) {
+					EdgeSourcePlanes& planes = edge_source_planes[cir->halfedge()];
+					planes.insert(r.edge_planes[2 * j]);
+					planes.insert(r.edge_planes[2 * j + 1]);
+					j = (j + 1) % num;
+				}
+			}
+			builder.end_surface();
+		}
+
+		if (rejected) {
+			delete mesh;
+			return nil;
+		}
+		complete_border_source_planes(mesh);
+		complete_split_vertex_source_planes(mesh);
+		return mesh;
+	}
+
+}
+
+
+// The checkpoint is a binary file of:
+//  - a header: the magic "PFCK", the version, the number of points of the point set, if the candidate
+//    faces are from the kinetic partition, and the average spacing of the points (0 if unknown);
+//  - the box of the last generate(): the ids of the planes of its 6 faces (-1 if there is no box) and 
+//    its corners (padded);
+//  - the planar segments: the plane, the color, and the point indices of each of them;
+//  - the supporting planes: the coefficients and the index of the segment (-1 for the box planes);
+//  - the vertices: the position and the ids of the three source planes;
+//  - the facets: the vertices, the source planes of the edges (the edge to vertex j is given at j),
+//    the supporting plane and segment, the color, and the three quality measures.
+bool HypothesisGenerator::save_candidates(Map* mesh, const std::string& file_name) const {
+	if (!pset_ || !mesh || !ready_for_optimization(mesh)) {
+		Logger::err("-") << "no candidate faces (with confidences) to save" << std::endl;
+		return false;
+	}
+
+	MapVertexAttribute<VertexSourcePlanes>	vertex_source_planes(mesh, "VertexSourcePlanes");
+	MapHalfedgeAttribute<EdgeSourcePlanes>	edge_source_planes(mesh, "EdgeSourcePlanes");
+	FOR_EACH_HALFEDGE(Map, mesh, it) {
+		if (it->facet() != nil && (edge_source_planes[it].size() != 2 || vertex_source_planes[it->vertex()].size() != 3)) {
+			Logger::err("-") << "the source planes of the candidate faces are incomplete. Nothing is saved" << std::endl;
+			return false;
+		}
+	}
+
+	std::ofstream output(file_name.c_str(), std::fstream::binary);
+	if (output.fail()) {
+		Logger::err("-") << "could not open file\'" << file_name << "\'" << std::endl;
+		return false;
+	}
+
+	output.write(checkpoint_magic, sizeof(checkpoint_magic));
+	write_value(output, checkpoint_version);
+	write_value(output, static_cast<int>(pset_->points().size()));
+	write_value(output, static_cast<int>(kinetic_));
+	write_value(output, avg_spacing_);
+
+	int box_planes[6] = { -1, -1, -1, -1, -1, -1 };
+	float box_corners[6] = { 0, 0, 0, 0, 0, 0 };
+	if (bbox_mesh_) {
+		MapFacetAttribute<Plane3d*> box_plane(bbox_mesh_, "FacetSupportingPlane");
+		int k = 0;
+		FOR_EACH_FACET(Map, bbox_mesh_, it)
+			box_planes[k++] = static_cast<int>(plane_id(box_plane[it]));
+		const Box3d& box = bbox_mesh_->bbox();
+		float corners[6] = { box.x_min(), box.y_min(), box.z_min(), box.x_max(), box.y_max(), box.z_max() };
+		std::copy(corners, corners + 6, box_corners);
+	}
+	output.write(reinterpret_cast<const char*>(box_planes), sizeof(box_planes));
+	output.write(reinterpret_cast<const char*>(box_corners), sizeof(box_corners));
+
+	const std::vector<VertexGroup::Ptr>& groups = pset_->groups();
+	std::map<const VertexGroup*, int> group_index;
+	write_value(output, static_cast<int>(groups.size()));
+	for (std::size_t i = 0; i < groups.size(); ++i) {
+		const VertexGroup* g = groups[i];
+		group_index[g] = static_cast<int>(i);
+		write_plane(output, g->plane());
+		output.write(reinterpret_cast<const char*>(g->color().data()), sizeof(float) * 3);
+		write_value(output, static_cast<int>(g->size()));
+		output.write(reinterpret_cast<const char*>(g->data()), g->size() * sizeof(unsigned int));
+	}
+
+	std::map<const Plane3d*, int> plane_group;	// the segment of each segment plane
+	std::map<VertexGroup*, Plane3d*>::const_iterator pos = vertex_group_plane_.begin();
+	for (; pos != vertex_group_plane_.end(); ++pos) {
+		std::map<const VertexGroup*, int>::const_iterator it = group_index.find(pos->first);
+		if (it != group_index.end())
+			plane_group[pos->second] = it->second;
+	}
+	write_value(output, static_cast<int>(supporting_planes_.size()));
+	for (std::size_t i = 0; i < supporting_planes_.size(); ++i) {
+		write_plane(output, *supporting_planes_[i]);
+		std::map<const Plane3d*, int>::const_iterator it = plane_group.find(supporting_planes_[i]);
+		write_value(output, it == plane_group.end() ? -1 : it->second);
+	}
+
+	MapFacetAttribute<Plane3d*>				supporting_plane(mesh, "FacetSupportingPlane");
+	MapFacetAttribute<VertexGroup*>			supporting_group(mesh, Method::facet_attrib_supporting_vertex_group);
+	MapFacetAttribute<Color>				color(mesh, "color");
+	MapFacetAttribute<double>				supporting_point_num(mesh, Method::facet_attrib_supporting_point_num);
+	MapFacetAttribute<double>				facet_area(mesh, Method::facet_attrib_facet_area);
+	MapFacetAttribute<double>				covered_area(mesh, Method::facet_attrib_covered_area);
+
+	MapVertexAttribute<int> vertex_index(mesh);
+	int idx = 0;
+	write_value(output, static_cast<int>(mesh->size_of_vertices()));
+	FOR_EACH_VERTEX(Map, mesh, it) {
+		vertex_index[it] = idx++;
+		write_value(output, it->point());
+		const VertexSourcePlanes& planes = vertex_source_planes[it];
+		for (std::size_t k = 0; k < 3; ++k)
+			write_value(output, planes[k]);
+	}
+
+	write_value(output, static_cast<int>(mesh->size_of_facets()));
+	FOR_EACH_FACET(Map, mesh, it) {
+		std::vector<int> vertices;
+		std::vector<unsigned int> edge_planes;
+		FacetHalfedgeCirculator cir(it);
+		for (; !cir->end(); ++cir) {
+			MapTypes::Halfedge* h = cir->halfedge();
+			vertices.push_back(vertex_index[h->vertex()]);
+			const EdgeSourcePlanes& planes = edge_source_planes[h];
+			edge_planes.push_back(planes[0]);
+			edge_planes.push_back(planes[1]);
+		}
+		write_value(output, static_cast<int>(vertices.size()));
+		output.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(int));
+		output.write(reinterpret_cast<const char*>(edge_planes.data()), edge_planes.size() * sizeof(unsigned int));
+
+		write_value(output, plane_id(supporting_plane[it]));
+		std::map<const VertexGroup*, int>::const_iterator g = group_index.find(supporting_group[it]);
+		write_value(output, g == group_index.end() ? -1 : g->second);
+		output.write(reinterpret_cast<const char*>(color[it].data()), sizeof(float) * 4);
+		write_value(output, supporting_point_num[it]);
+		write_value(output, facet_area[it]);
+		write_value(output, covered_area[it]);
+	}
+	vertex_index.unbind();
+
+	Logger::out("-") << "candidate faces saved: " << mesh->size_of_facets() << " faces, " 
+		<< groups.size() << " planar segments" << std::endl;
+	return !output.fail();
+}
+
+
+Map* HypothesisGenerator::load_candidates(const std::string& file_name) {
+	if (!pset_)
+		return nil;
+
+	std::ifstream input(file_name.c_str(), std::fstream::binary);
+	if (input.fail()) {
+		Logger::err("-") << "could not open file\'" << file_name << "\'" << std::endl;
+		return nil;
+	}
+	input.seekg(0, std::ios::end);
+	const std::streamoff file_size = input.tellg();
+	input.seekg(0, std::ios::beg);
+
+	char magic[4];
+	int version = 0, num_points = 0, kinetic = 0;
+	double avg_spacing = 0;
+	int box_planes[6];
+	float box_corners[6];
+	input.read(magic, sizeof(magic));
+	read_value(input, version);
+	read_value(input, num_points);
+	read_value(input, kinetic);
+	read_value(input, avg_spacing);
+	input.read(reinterpret_cast<char*>(box_planes), sizeof(box_planes));
+	input.read(reinterpret_cast<char*>(box_corners), sizeof(box_corners));
+	if (input.fail() || !std::equal(magic, magic + 4, checkpoint_magic) || version != checkpoint_version) {
+		Logger::err("-") << "not a candidate checkpoint (or an unsupported version): " << file_name << std::endl;
+		return nil;
+	}
+	if (num_points != static_cast<int>(pset_->points().size())) {
+		Logger::err("-") << "the checkpoint was saved for a point set of " << num_points << " points (this one has "
+			<< pset_->points().size() << ")" << std::endl;
+		return nil;
+	}
+
+	// Everything is read and validated before the state of the generator is touched, so a corrupted
+	// file leaves it unchanged. A count is only accepted if the rest of the file can hold its items,
+	// which rejects the garbage counts before anything is allocated.
+	auto fits = [&](int count, std::size_t item_size) -> bool {
+		if (input.fail() || count < 0)
+			return false;
+		std::streamoff remaining = file_size - static_cast<std::streamoff>(input.tellg());
+		return static_cast<double>(count) * item_size <= static_cast<double>(remaining);
+	};
+	auto corrupted = [&]() -> Map* {
+		Logger::err("-") << "the checkpoint is truncated or corrupted: " << file_name << std::endl;
+		return nil;
+	};
+
+	// the planar segments replace the ones of the point set (they may have been refined)
+	int num_groups = 0;
+	read_value(input, num_groups);
+	if (!fits(num_groups, sizeof(float) * 7 + sizeof(int)))
+		return corrupted();
+	std::vector<VertexGroup::Ptr> groups;
+	for (int i = 0; i < num_groups; ++i) {
+		VertexGroup::Ptr g = new VertexGroup(pset_);
+		g->set_plane(read_plane(input));
+		float c[3];
+		input.read(reinterpret_cast<char*>(c), sizeof(c));
+		g->set_color(Color(c));
+		int num = 0;
+		read_value(input, num);
+		if (num > num_points || !fits(num, sizeof(unsigned int)))
+			return corrupted();
+		g->resize(num);
+		input.read(reinterpret_cast<char*>(g->data()), num * sizeof(unsigned int));
+		for (int j = 0; j < num; ++j) {
+			if (g->at(j) >= static_cast<unsigned int>(num_points))
+				return corrupted();
+		}
+		groups.push_back(g);
+	}
+
+	int num_planes = 0;
+	read_value(input, num_planes);
+	if (!fits(num_planes, sizeof(float) * 4 + sizeof(int)) || num_planes > static_cast<int>(PlaneTripletTable::max_num_planes))
+		return corrupted();
+	std::vector<Plane3d> saved_planes;
+	std::vector<int> plane_groups;
+	for (int i = 0; i < num_planes; ++i) {
+		saved_planes.push_back(read_plane(input));
+		int g = -1;
+		read_value(input, g);
+		plane_groups.push_back(g);
+	}
+
+	// the box planes are either all given or none of them
+	int num_box_planes = 0;
+	for (int k = 0; k < 6; ++k) {
+		if (box_planes[k] >= num_planes || box_planes[k] < -1)
+			return corrupted();
+		if (box_planes[k] >= 0)
+			++num_box_planes;
+	}
+	if (num_box_planes != 0 && num_box_planes != 6)
+		return corrupted();
+	if (num_box_planes == 6 && !(box_corners[0] <= box_corners[3] && box_corners[1] <= box_corners[4] && box_corners[2] <= box_corners[5]))
+		return corrupted();
+	if (!(avg_spacing >= 0))
+		return corrupted();
+
+	int num_vertices = 0;
+	read_value(input, num_vertices);
+	if (!fits(num_vertices, sizeof(vec3) + sizeof(unsigned int) * 3))
+		return corrupted();
+	std::vector<vec3> points(num_vertices);
+	std::vector<VertexSourcePlanes> point_planes(num_vertices);
+	for (int i = 0; i < num_vertices; ++i) {
+		unsigned int ids[3];
+		read_value(input, points[i]);
+		input.read(reinterpret_cast<char*>(ids), sizeof(ids));
+		for (std::size_t k = 0; k < 3; ++k) {
+			if (ids[k] >= static_cast<unsigned int>(num_planes))
+				return corrupted();
+			point_planes[i].insert(ids[k]);
+		}
+	}
+
+	int num_facets = 0;
+	read_value(input, num_facets);
+	if (!fits(num_facets, sizeof(int) * 5 + sizeof(float) * 4 + sizeof(double) * 3))
+		return corrupted();
+	std::vector<CheckpointFacet> facets(num_facets);
+	for (int i = 0; i < num_facets; ++i) {
+		CheckpointFacet& r = facets[i];
+		int num = 0;
+		read_value(input, num);
+		if (num < 3 || !fits(num, sizeof(int) + sizeof(unsigned int) * 2))
+			return corrupted();
+		r.vertices.resize(num);
+		r.edge_planes.resize(num * 2);
+		input.read(reinterpret_cast<char*>(r.vertices.data()), num * sizeof(int));
+		input.read(reinterpret_cast<char*>(r.edge_planes.data()), r.edge_planes.size() * sizeof(unsigned int));
+		read_value(input, r.plane);
+		read_value(input, r.group);
+		input.read(reinterpret_cast<char*>(r.color), sizeof(r.color));
+		read_value(input, r.point_num);
+		read_value(input, r.area);
+		read_value(input, r.covered);
+		if (input.fail() || r.plane >= static_cast<unsigned int>(num_planes))
+			return corrupted();
+		for (int j = 0; j < num; ++j) {
+			if (r.vertices[j] < 0 || r.vertices[j] >= num_vertices)
+				return corrupted();
+		}
+		for (std::size_t j = 0; j < r.edge_planes.size(); ++j) {
+			if (r.edge_planes[j] >= static_cast<unsigned int>(num_planes))
+				return corrupted();
+		}
+	}
+
+	std::vector<Plane3d*> planes(num_planes);
+	for (int i = 0; i < num_planes; ++i)
+		planes[i] = new Plane3d(saved_planes[i]);
+	Map* mesh = build_checkpoint_mesh(points, point_planes, facets, planes, groups);
+	if (!mesh) {
+		for (int i = 0; i < num_planes; ++i)
+			delete planes[i];
+		return corrupted();
+	}
+
+	// the state of the generator is replaced only now
+	clear();
+	plane_segments_.clear();
+	vertex_group_plane_.clear();
+	kinetic_ = (kinetic != 0);
+	avg_spacing_ = avg_spacing;
+
+	for (int i = 0; i < num_planes; ++i) {
+		add_supporting_plane(planes[i]);
+		int g = plane_groups[i];
+		if (g >= 0 && g < num_groups) {
+			plane_segments_.push_back(groups[g]);
+			vertex_group_plane_[groups[g]] = planes[i];
+		}
+	}
+	pset_->groups() = groups;
+
+	// the box is restored on its own planes, so update() can clip the new planes with it
+	if (num_box_planes == 6) {
+		std::vector<Plane3d*> box_faces(6);
+		for (int k = 0; k < 6; ++k)
+			box_faces[k] = planes[box_planes[k]];
+		Box3d box;
+		box.add_point(vec3(box_corners[0], box_corners[1], box_corners[2]));
+		box.add_point(vec3(box_corners[3], box_corners[4], box_corners[5]));
+		bbox_mesh_ = construct_bbox_mesh(box, 0.0f, box_faces);
+		init_triplet_intersection(bbox_mesh_->bbox());
+	}
+
+	Logger::out("-") << "candidate faces loaded: " << mesh->size_of_facets() << " faces, "
+		<< groups.size() << " planar segments" << std::endl;
+	return mesh;
+}
@@ -18,19 +18,25 @@
 #define _HYPOTHESIS_GENERATOR_
 
 #include <method/method_common.h>
+#include <method/plane_triplet_table.h>
+#include <method/source_planes.h>
 #include <math/polygon2d.h>
 #include <model/vertex_group.h>
 #include <model/map_attributes.h>
 
 #include <string>
 #include <vector>
+#include <map>
+#include <unordered_map>
 
 
 class Map;
 class PointSet;
 class VertexGroup;
 class MapEditor;
+class MapBuilder;
 class ProgressLogger;
+class FacetBoxTree;
 
 namespace MapTypes {
 	class Vertex;
@@ -48,36 +54,311 @@ public:
 
 	Map* generate();
 
+	// An alternative to generate() for the inputs with many planes (e.g., 1000+), for which the full
+	// arrangement of the planes gives too many candidate faces. The planes are partitioned by kinetic
+	// propagation: the polygon of each plane starts from the convex hull of its points and grows until 
+	// it hits the polygons of other planes, and the pieces of a polygon that no other polygon separates
+	// are merged. So the candidate faces are far fewer and larger (and not necessarily convex). Unlike
+	// the arrangement, a face is only cut by the planes whose polygons collide with its own one, so the
+	// cost grows with the number of collisions instead of the number of plane pairs. The result has the
+	// same attributes as the one of generate(), but an edge may also be shared by two (coplanar) or 
+	// three faces (a polygon stopped by another one).
+	Map* generate_kinetic();
+
 	void compute_confidences(Map* mesh, bool use_conficence = false);
 
-	// Intersection: a set of 'faces' intersecting at a common edge
-	struct SuperEdge : public std::vector<MapTypes::Halfedge*> {
-		const vec3* s;
-		const vec3* t;
+	// The changes of the planar segments since the candidate faces were generated. The groups of the 
+	// point set are expected to be changed accordingly by the caller, i.e., an 'added' segment is a new
+	// group, a 'modified' segment has different points (its plane is refitted), and a 'removed' one is
+	// no longer used.
+	struct PlaneDelta {
+		std::vector<VertexGroup*>	added;
+		std::vector<VertexGroup*>	removed;
+		std::vector<VertexGroup*>	modified;
+	};
+
+	// Updates the candidate faces 'mesh' (the result of the last generate() followed by 
+	// compute_confidences()) for 'delta' instead of generating them again. Only the faces of the 
+	// changed planes and of the planes they used to cross are rebuilt from their proxy faces, and the 
+	// other faces are cut only by the new planes. The quality measures are recomputed for the faces of 
+	// the affected planes only (the coverage of a face depends on all the faces of its plane), or for
+	// all the faces if compute_confidences() has not been called. The planes of the 'modified' segments
+	// are fitted from scratch (their cached moments are discarded). Not supported for the candidate 
+	// faces of generate_kinetic() (returns false).
+	// Note: a plane crossed by a removed or modified plane is rebuilt entirely, not only its faces
+	//       along the retired plane. Since the proxy faces span the whole box, this is often most of
+	//       the planes, and then the update costs about as much as generate(). It mainly pays off when
+	//       segments are only added, or when the changed planes cross few others.
+	bool update(Map* mesh, const PlaneDelta& delta, bool use_conficence = false);
+
+	// how compute_confidences() estimates the area of a candidate face covered by its supporting points
+	enum CoverageEstimator {
+		ALPHA_SHAPE,	// the alpha shape of the points (default)
+		RASTER			// the occupancy of a 2D grid, much faster but approximate (see RasterCoverage)
+	};
+	void set_coverage_estimator(CoverageEstimator e) { coverage_estimator_ = e; }
+	CoverageEstimator coverage_estimator() const { return coverage_estimator_; }
+
+	// Intersection: a set of 'faces' intersecting at a common edge, given by their halfedges. It is a 
+	// (lightweight) view of the halfedges stored in an Adjacency.
+	class SuperEdge {
+	public:
+		typedef MapTypes::Halfedge* const*	const_iterator;
+
+		SuperEdge(const_iterator first, const_iterator last, const vec3& s, const vec3& t) 
+			: s(s), t(t), first_(first), last_(last) {}
+
+		std::size_t size() const { return last_ - first_; }
+		MapTypes::Halfedge* operator[](std::size_t i) const { return first_[i]; }
+		const_iterator begin() const { return first_; }
+		const_iterator end() const { return last_; }
+
+		vec3 s;
+		vec3 t;
+
+	private:
+		const_iterator first_;
+		const_iterator last_;
+	};
+
+	// All the super edges in a flat (CSR) layout: the halfedges of super edge i are halfedges()[j] for
+	// offsets()[i] <= j < offsets()[i + 1], and its end points are end_points()[2i] and end_points()[2i + 1].
+	class Adjacency {
+	public:
+		Adjacency() : offsets_(1, 0), kinetic_(false) {}
+
+		std::size_t size() const { return offsets_.size() - 1; }
+		bool empty() const { return size() == 0; }
+
+		// if two faces of super edge i can be selected together. An intersecting edge of the arrangement 
+		// of the planes (i.e., generate()) is shared by 4 faces, so its other fans are never used. The 
+		// edges of the kinetic partition (i.e., generate_kinetic()) are also shared by 3 faces (where a 
+		// plane stops at another one) and by 2 coplanar faces.
+		bool usable(std::size_t i) const {
+			std::size_t n = offsets_[i + 1] - offsets_[i];
+			return kinetic_ ? (n > 1) : (n == 4);
+		}
+
+		SuperEdge operator[](std::size_t i) const {
+			const_iterator first = halfedges_.data() + offsets_[i];
+			const_iterator last = halfedges_.data() + offsets_[i + 1];
+			return SuperEdge(first, last, end_points_[2 * i], end_points_[2 * i + 1]);
+		}
+
+		const std::vector<std::size_t>&			offsets() const { return offsets_; }
+		const std::vector<MapTypes::Halfedge*>&	halfedges() const { return halfedges_; }
+		const std::vector<vec3>&				end_points() const { return end_points_; }
+
+	private:
+		typedef SuperEdge::const_iterator const_iterator;
+
+		std::vector<std::size_t>			offsets_;
+		std::vector<MapTypes::Halfedge*>	halfedges_;
+		std::vector<vec3>					end_points_;
+		bool								kinetic_;	// the edges are from the kinetic partition
+
+		friend class HypothesisGenerator;
 	};
-	typedef typename std::vector<SuperEdge>		Adjacency;
 
 	// the adjacency information will be used to formulate the hard constraints.
 	Adjacency extract_adjacency(Map* mesh);
 
 	bool ready_for_optimization(Map* mesh) const;
 
+	// A checkpoint of the candidate faces, e.g., to tune the weights of the face selection without
+	// recomputing the candidate faces and their confidences. save_candidates() writes 'mesh' (with its 
+	// quality measures and source planes), the supporting planes, the planar segments, the box of the 
+	// last generate() and the average spacing of the points into a binary file (nothing is written if a 
+	// source plane of 'mesh' is missing). load_candidates() restores them for the same point set: the 
+	// segments of the point set are replaced by the saved ones (which may have been refined) and the 
+	// returned mesh is ready for the optimization and for update(). If the file is not valid, nothing is
+	// changed and nil is returned. NOTE: the previous
+	// candidate meshes of this generator are no longer valid after loading (their supporting planes are 
+	// released).
+	bool save_candidates(Map* mesh, const std::string& file_name) const;
+	Map* load_candidates(const std::string& file_name);
+
+	// number of threads used for cutting the proxy faces (default is 1, i.e., sequential).
+	// A value of 0 means using all the hardware threads. The candidate faces do not depend on it, but a 
+	// single thread cuts them in place, so they are stored in another order than with multiple threads.
+	void set_num_threads(int n) { num_threads_ = n; }
+	int  num_threads() const { return num_threads_; }
+
+	// how the proxy faces are cut into the candidate faces
+	enum CuttingMethod {
+		INCREMENTAL_CUT,	// cut each face by the planes one after another (default)
+		LINE_ARRANGEMENT	// compute the arrangement of all the cutting lines of a face at once
+	};
+	void set_cutting_method(CuttingMethod m) { cutting_method_ = m; }
+	CuttingMethod cutting_method() const { return cutting_method_; }
+
+	// how the intersecting points of the plane triplets have been computed
+	struct TripletStatistics {
+		std::size_t num_queries;		// number of queries
+		std::size_t num_computed;		// number of triplets computed (i.e., the misses)
+		std::size_t num_culled;			// computed, but the point is outside the bbox
+		std::size_t num_degenerate;		// computed, but the planes do not meet at a single point
+		std::size_t memory;				// memory (in bytes) used by the data base
+		double		compute_time;		// time (in sec.) spent on computing the triplets
+
+		TripletStatistics() : num_queries(0), num_computed(0), num_culled(0), num_degenerate(0), memory(0), compute_time(0) {}
+	};
+	const TripletStatistics& triplet_statistics() const { return triplet_stats_; }
+
+	// The intersecting points computed by a worker thread. During a parallel stage the data base is only
+	// read (without locking), and the triplets missing there are computed into the cache of the thread.
+	// The caches are merged into the data base after the stage (see merge_triplet_caches()). The Logger
+	// is not synchronized, so the warnings of the thread are also kept here and logged by the merge.
+	struct TripletCache {
+		PlaneTripletTable					table;
+		TripletStatistics					stats;
+		std::map<std::string, std::size_t>	warnings;	// the message and how many times it was given
+	};
+
 private:
-	// construct mesh for the bbox of the point set
-	Map* construct_bbox_mesh();
+	// construct mesh for a box (padded by 'delta'), e.g., the bbox of the point set. The planes of its 
+	// faces are appended to the supporting planes, or the existing 'planes' (6, in the order of the 
+	// faces) are used, e.g., to restore the box of a checkpoint.
+	Map* construct_bbox_mesh(const Box3d& box, float delta, const std::vector<Plane3d*>& planes = std::vector<Plane3d*>());
 
 	Map* compute_proxy_mesh(Map* bbox_mesh);
 
-	// pairwise cut
-	void pairwise_cut(Map* mesh);
+	// appends the proxy faces of the 'segments' (i.e., their planes clipped by the box of 'bbox_mesh') 
+	// to the surface being built by 'builder'. 'idx' is the index of the next vertex.
+	void add_proxy_faces(Map* bbox_mesh, const std::vector<VertexGroup*>& segments, MapBuilder& builder, int& idx);
 
 private:
+	// the attributes that are read and modified when cutting faces. The sequential cut uses the
+	// ones bound to the candidate mesh, and each parallel task binds its own to a private mesh.
+	struct CutAttributes {
+		MapFacetAttribute<VertexGroup*>				supporting_vertex_group;
+		MapFacetAttribute<Plane3d*>					supporting_plane;
+
+		// to avoid numerical issues (there are always small differences when computing the intersecting 
+		// point of a plane triplet), I store how a edge is computed (from two planes). Then, I just need 
+		// to query the intersecting point of a plane triplet 
+		// from a precomputed table. By doing so, I can avoid this numerical issues.  
+		MapHalfedgeAttribute<EdgeSourcePlanes>		edge_source_planes;
+		MapVertexAttribute<VertexSourcePlanes>		vertex_source_planes;
+
+		// the cache of the thread cutting the mesh (nil if it is not cut by a worker thread)
+		TripletCache*								triplets;
+
+		CutAttributes() : triplets(nil) {}
+		void bind(Map* mesh);
+		void unbind();
+	};
+
+	// generate() and generate_kinetic()
+	Map* generate_candidates(bool kinetic);
+
+	// collects all the faces of 'mesh' and the planes cutting each of them
+	void collect_all_cutting_planes(
+		Map* mesh,
+		CutAttributes& attribs,
+		std::vector<MapTypes::Facet*>& faces,
+		std::vector< std::set<Plane3d*> >& cutting_planes
+	);
+
+	// pairwise cut
+	void pairwise_cut(Map* mesh, CutAttributes& attribs);
+
+	// cuts the (unconnected) proxy 'faces' by their 'cutting_planes' (emptied on return), using the 
+	// cutting method and the number of threads of this generator
+	void cut_proxy_faces(
+		Map* mesh,
+		CutAttributes& attribs,
+		const std::vector<MapTypes::Facet*>& faces,
+		std::vector< std::set<Plane3d*> >& cutting_planes
+	);
+
+	// cuts the 'faces' (concurrently if multiple threads are used). With multiple threads, each face is 
+	// copied into its own mesh, cut there, and the pieces are put back into 'mesh' in the order of the 
+	// faces, so the result is the same for any number of threads. A single thread cuts the faces in place.
+	void piecewise_cut(
+		Map* mesh,
+		CutAttributes& attribs,
+		const std::vector<MapTypes::Facet*>& faces,
+		std::vector< std::set<Plane3d*> >& cutting_planes,
+		int num_threads
+	);
+
+	// A proxy face and the ids of the planes cutting it, extracted from the mesh for arrange_face(). 
+	// Edge i goes from corner i to corner i + 1 and it lies on plane edge_planes[i] (and the face's plane).
+	struct ProxyFace {
+		unsigned int					plane;
+		std::vector<vec3>				corners;
+		std::vector<VertexSourcePlanes>	corner_planes;
+		std::vector<unsigned int>		edge_planes;
+		std::vector<unsigned int>		cutting_planes;
+	};
+
+	// The cells of the arrangement of a proxy face. Edge j of a cell goes from its point j to point 
+	// j + 1, and it lies on plane edge_planes[j] (and the face's plane).
+	struct FaceCells {
+		std::vector<vec3>					points;
+		std::vector<VertexSourcePlanes>		point_planes;
+		std::vector< std::vector<int> >		cells;
+		std::vector< std::vector<unsigned int> >	edge_planes;
+	};
+
+	// computes the 2D arrangement of the lines along which 'face' intersects its cutting planes. All the
+	// intersections are computed in a batch, and the cells are traced from the resulting planar graph. 
+	// NOTE: thread safe if each thread has its own 'triplets' (see query_intersection()).
+	void arrange_face(const ProxyFace& face, FaceCells& cells, TripletCache* triplets);
+
+	// extracts proxy face 'f' and the ids of its 'cutting_planes'
+	void extract_proxy_face(MapTypes::Facet* f, const std::set<Plane3d*>& cutting_planes, CutAttributes& attribs, ProxyFace& face);
+
+	// arranges the 'faces' given by their indices in 'tasks' (concurrently if multiple threads are used)
+	void arrange_faces(
+		const std::vector<ProxyFace>& faces, 
+		const std::vector<std::size_t>& tasks, 
+		std::vector<FaceCells>& cells, 
+		int num_threads
+	);
+
+	// replaces the 'faces' given by their indices in 'tasks' by their cells in 'outputs' (in the order
+	// of the faces). Returns the number of new faces.
+	std::size_t replace_faces_by_cells(
+		Map* mesh,
+		CutAttributes& attribs,
+		const std::vector<MapTypes::Facet*>& faces,
+		const std::vector<std::size_t>& tasks,
+		const std::vector<ProxyFace>& inputs,
+		const std::vector<FaceCells>& outputs
+	);
+
+	// the alternative to cutting the faces one plane after another: the faces are replaced by the cells 
+	// of their line arrangements (computed concurrently if multiple threads are used).
+	void arrangement_pairwise_cut(
+		Map* mesh,
+		CutAttributes& attribs,
+		const std::vector<MapTypes::Facet*>& faces,
+		const std::vector< std::set<Plane3d*> >& cutting_planes,
+		int num_threads
+	);
+
+	// the planes of the kinetic partition (see generate_kinetic()). The polygons grow on the line 
+	// arrangements of the proxy faces, and the lines are added on demand: the time horizon of the 
+	// propagation is doubled round by round, and the faces whose polygons collide in a round are
+	// arranged again with the planes of each other.
+	void kinetic_partition(Map* mesh, CutAttributes& attribs, int num_threads);
+
+	// cut face 'f' by all the 'cutting_planes' (emptied on return)
+	void cut_face(MapTypes::Facet* f, std::set<Plane3d*>& cutting_planes, Map* mesh, CutAttributes& attribs);
+
 	void collect_valid_planes();
 
-	void merge(VertexGroup* g1, VertexGroup* g2);
+	// the number of threads to use (i.e., num_threads_ with 0 resolved to all hardware threads)
+	int resolved_num_threads() const;
+
+	// merges two vertex groups into a new one (with its plane fitted). The groups of the point set
+	// are not changed.
+	VertexGroup::Ptr merge(VertexGroup* g1, VertexGroup* g2);
 
 	// test if face 'f' insects plane 'plane'
-	bool do_intersect(MapTypes::Facet* f, Plane3d* plane);
+	bool do_intersect(MapTypes::Facet* f, Plane3d* plane, CutAttributes& attribs);
 
     struct Intersection {
         enum Type { EXISTING_VERTEX, NEW_VERTEX };
@@ -99,35 +380,81 @@ private:
     void compute_intersections(
             MapTypes::Facet* f,
             Plane3d* plane,
-            std::vector<Intersection>& intersections
+            std::vector<Intersection>& intersections,
+            CutAttributes& attribs
     );
 
-	std::vector<MapTypes::Facet*> cut(MapTypes::Facet* f, Plane3d* cutter, Map* mesh);
+	std::vector<MapTypes::Facet*> cut(MapTypes::Facet* f, Plane3d* cutter, Map* mesh, CutAttributes& attribs);
 
 	// split an existing edge, meanwhile, assign the new edges the original source faces (the old edge 
 	// lies in the intersection of the two faces)
-	MapTypes::Vertex* split_edge(const Intersection& ep, MapEditor* editor, Plane3d* cutting_plane);
-
-	// collect all faces in 'mesh' that intersect 'face'
-	std::set<Plane3d *> collect_cutting_planes(MapTypes::Facet* face, Map* mesh);
-
-	void triplet_intersection();
-
-	// query the intersecting point for existing data base, i.e., triplet_intersection_
-	vec3* query_intersection(Plane3d* plane1, Plane3d* plane2, Plane3d* plane3);
+	MapTypes::Vertex* split_edge(const Intersection& ep, MapEditor* editor, Plane3d* cutting_plane, CutAttributes& attribs);
+
+	// collect the supporting planes of all 'faces' that intersect 'face'. Only the faces reported by 
+	// 'tree' (the AABB tree of 'faces') as crossing the plane of 'face' are actually tested.
+	std::set<Plane3d *> collect_cutting_planes(
+		MapTypes::Facet* face,
+		const std::vector<MapTypes::Facet*>& faces,
+		const FacetBoxTree& tree,
+		CutAttributes& attribs
+	);
+
+	// reset the data base of the intersecting points of the plane triplets. The points are computed
+	// on demand (see query_intersection()), and only the ones inside 'box' are kept.
+	void init_triplet_intersection(const Box3d& box);
+
+	// query the intersecting point of a plane triplet from the data base, i.e., triplet_intersection_.
+	// The point is computed (and memorized) the first time a triplet is queried. Returns false if the 
+	// planes do not intersect at a single point or if the point is outside the box. 
+	// The planes are given by their ids (see plane_id()).
+	// NOTE: a worker thread must give its own 'triplets' cache, where the triplets missing in the data 
+	//       base are memorized. The data base itself is only modified if 'triplets' is nil.
+	bool query_intersection(unsigned int id1, unsigned int id2, unsigned int id3, vec3& p, TripletCache* triplets = nil);
+
+	// merges the 'caches' of the worker threads (and their statistics) into the data base, and logs the
+	// warnings of the threads. It must be called by the calling thread after the workers are joined.
+	void merge_triplet_caches(const std::vector<TripletCache>& caches);
+
+	// logs a warning, or keeps it in 'triplets' if it is given by a worker thread (see TripletCache)
+	void warn(TripletCache* triplets, const std::string& message);
+
+	// appends a plane to supporting_planes_ and returns its id (i.e., its index)
+	unsigned int add_supporting_plane(Plane3d* plane);
+
+	// the id of a supporting plane, which is used in the source planes of the edges/vertices
+	unsigned int plane_id(const Plane3d* plane) const;
 
 	// compute the intersection of a plane triplet
-	// returns true if the intersection exists (p returns the point)
-	bool intersection_plane_triplet(const Plane3d* plane1, const Plane3d* plane2, const Plane3d* plane3, vec3& p);
+	// returns true if the intersection exists (p returns the point). The warnings go to 'triplets' if
+	// it is given (see warn()).
+	bool intersection_plane_triplet(const Plane3d* plane1, const Plane3d* plane2, const Plane3d* plane3, vec3& p, TripletCache* triplets = nil);
 
 	// the pairwise intersection may result in tiny faces and we may have numerical problems when computing the 
 	// face confidences where face area is the denominator. To handle this, we simply remove these degenerate 
 	// faces by collapsing the edges.
 	void remove_degenerated_facets(Map* mesh);
 
-	// std::vector<unsigned int>& points returns the point indices projected in f.
-	// returns the 'number' of points projected in f (accounts for a notion of confidence)
-	float facet_points_projected_in(PointSet* pset, VertexGroup* g, MapTypes::Facet* f, float max_dist, std::vector<unsigned int>& points);
+	// finds the points projected in each of the 'facets' ('groups' gives their supporting vertex groups).
+	// The points of each group are projected only once and then located in the facets of the group using
+	// a 2D grid. 'points' returns the point indices projected in each facet, and 'counts' the 'number' of
+	// these points (accounts for a notion of confidence).
+	void assign_points_to_facets(
+		const std::vector<MapTypes::Facet*>& facets, 
+		const std::vector<VertexGroup*>& groups, 
+		float max_dist,
+		std::vector< std::vector<unsigned int> >& points,
+		std::vector<float>& counts
+	);
+
+	// computes the quality measures of the 'facets' of 'mesh' (see compute_confidences()) using the 
+	// point confidences computed before. The progress continues from 'num_done_before'.
+	void compute_facet_confidences(
+		Map* mesh, 
+		const std::vector<MapTypes::Facet*>& facets, 
+		bool use_conficence, 
+		ProgressLogger& progress, 
+		std::size_t num_done_before
+	);
 
 	// returns average spacing
 	float compute_point_confidences(PointSet* pset, int s1 = 6, int s2 = 16, int s3 = 32, ProgressLogger* progress = nullptr);
@@ -139,30 +466,36 @@ private:
 	PointSet* pset_;
 
 	MapFacetAttribute<VertexGroup*> facet_attrib_supporting_vertex_group_;
-	MapFacetAttribute<Plane3d*>		facet_attrib_supporting_plane_;
 
 	std::vector<VertexGroup::Ptr>		plane_segments_;
 	std::map<VertexGroup*, Plane3d*>	vertex_group_plane_;
 
 	std::vector<Plane3d*>  supporting_planes_;		// including the bbox face planes
 	float				   max_dist_;				// maximum distance to the supporting plane
+
+	Map*					bbox_mesh_;		// the box of the last generate(), which update() clips the new planes with
+	bool					kinetic_;		// true if the last candidate faces are from generate_kinetic()
+	double					avg_spacing_;	// the average spacing of the points (computed with the point confidences)
+
+	int						num_threads_;
+	CoverageEstimator		coverage_estimator_;
+	CuttingMethod			cutting_method_;
+
 	
-	// How to use: triplet_intersection_[plane_min][plane_mid][plane_max]
-	std::map<Plane3d*, std::map<Plane3d*, std::map<Plane3d*, vec3*> > >  triplet_intersection_;
+	// the id (i.e., the index in supporting_planes_) of each supporting plane
+	std::unordered_map<const Plane3d*, unsigned int>	plane_index_;
 
-	// precomputed intersecting points of all plane triplets
-	std::vector< vec3*>		intersecting_points_;
+	// the intersecting points of the plane triplets computed so far. A triplet is identified by the 
+	// ids of its planes.
+	PlaneTripletTable		triplet_intersection_;
 
-	// to avoid numerical issues (there are always small differences when computing the intersecting 
-	// point of a plane triplet), I store how a edge is computed (from two planes). Then, I just need 
-	// to query the intersecting point of a plane triplet 
-	// from a precomputed table. By doing so, I can avoid this numerical issues.  
-	MapHalfedgeAttribute< std::set<Plane3d*> > edge_source_planes_;
+	Box3d					triplet_box_;	// points outside this box are rejected
+	TripletStatistics		triplet_stats_;
 
 	// to avoid numerical issues (due to floating point precision, there are always small differences 
 	// when computing the intersection of a plane triplet), I store how a vertex is computed (from
 	// three planes). Then, I just need to compare the three plane to identify if two points are the same. 
-	MapVertexAttribute< std::set<Plane3d*> > vertex_source_planes_;
+	MapVertexAttribute<VertexSourcePlanes>	vertex_source_planes_;
 };
 
 #endif
@@ -0,0 +1,113 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#include <method/plane_triplet_table.h>
+
+#include <algorithm>
+#include <cassert>
+
+
+// the number of slots allocated for the first insertion. The table is enlarged (by a factor 
+// of 2) when it becomes more than half full.
+static const std::size_t initial_capacity = 1024;
+
+
+PlaneTripletTable::PlaneTripletTable() : size_(0) {
+}
+
+
+PlaneTripletTable::Key PlaneTripletTable::key(unsigned int i, unsigned int j, unsigned int k) {
+	if (i > j) std::swap(i, j);
+	if (j > k) std::swap(j, k);
+	if (i > j) std::swap(i, j);
+	assert(i < j && j < k && k < max_num_planes);
+	return (Key(i) << 42) | (Key(j) << 21) | Key(k);
+}
+
+
+std::size_t PlaneTripletTable::hash(Key key) {
+	// the finalizer of MurmurHash3
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return static_cast<std::size_t>(key);
+}
+
+
+const PlaneTripletTable::Entry* PlaneTripletTable::find(Key key) const {
+	if (entries_.empty())
+		return nil;
+
+	std::size_t mask = entries_.size() - 1;
+	for (std::size_t idx = hash(key) & mask; ; idx = (idx + 1) & mask) {
+		const Entry& e = entries_[idx];
+		if (e.key == key)
+			return &e;
+		else if (e.key == 0)
+			return nil;
+	}
+}
+
+
+void PlaneTripletTable::insert(Key key, const vec3& point, bool valid) {
+	if ((size_ + 1) * 2 > entries_.size())
+		rehash(std::max(initial_capacity, entries_.size() * 2));
+
+	std::size_t mask = entries_.size() - 1;
+	for (std::size_t idx = hash(key) & mask; ; idx = (idx + 1) & mask) {
+		Entry& e = entries_[idx];
+		if (e.key == 0 || e.key == key) {
+			if (e.key == 0)
+				++size_;
+			e.key = key;
+			e.point = point;
+			e.valid = valid;
+			return;
+		}
+	}
+}
+
+
+void PlaneTripletTable::merge(const PlaneTripletTable& other) {
+	for (std::size_t i = 0; i < other.entries_.size(); ++i) {
+		const Entry& e = other.entries_[i];
+		if (e.key != 0 && !find(e.key))
+			insert(e.key, e.point, e.valid);
+	}
+}
+
+
+void PlaneTripletTable::rehash(std::size_t capacity) {
+	std::vector<Entry> entries(capacity);
+	for (std::size_t i = 0; i < capacity; ++i)
+		entries[i].key = 0;
+	entries_.swap(entries);
+	size_ = 0;
+
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		const Entry& e = entries[i];
+		if (e.key != 0)
+			insert(e.key, e.point, e.valid);
+	}
+}
+
+
+void PlaneTripletTable::clear() {
+	std::vector<Entry>().swap(entries_);
+	size_ = 0;
+}
@@ -0,0 +1,76 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef _PLANE_TRIPLET_TABLE_H_
+#define _PLANE_TRIPLET_TABLE_H_
+
+#include <method/method_common.h>
+#include <math/math_types.h>
+
+#include <vector>
+
+
+// A flat hash table (open addressing, linear probing) that stores the intersecting point of
+// plane triplets. A triplet is identified by the indices of its planes, which are packed into
+// a single 64-bit key (21 bits for each index). The points are stored inline in the table.
+class METHOD_API PlaneTripletTable
+{
+public:
+	typedef unsigned long long Key;
+
+	struct Entry {
+		Key		key;	// 0 for an empty slot (a valid key is never 0 because i < j < k)
+		vec3	point;
+		bool	valid;	// false if the planes do not intersect at a single (valid) point
+	};
+
+	// the maximum number of planes that can be indexed
+	static const unsigned int max_num_planes = (1u << 21);
+
+public:
+	PlaneTripletTable();
+
+	// packs three (different) plane indices into a key. The order of the indices doesn't matter.
+	static Key key(unsigned int i, unsigned int j, unsigned int k);
+
+	// returns nil if the triplet has not been inserted yet
+	const Entry* find(Key key) const;
+
+	// inserts (or overwrites) the intersecting point of a triplet
+	void insert(Key key, const vec3& point, bool valid);
+
+	// inserts the triplets of 'other' that are not in this table yet
+	void merge(const PlaneTripletTable& other);
+
+	void clear();
+
+	std::size_t size() const { return size_; }
+	std::size_t capacity() const { return entries_.size(); }
+
+	// the memory (in bytes) used by the table
+	std::size_t memory() const { return entries_.size() * sizeof(Entry); }
+
+private:
+	static std::size_t hash(Key key);
+
+	void rehash(std::size_t capacity);
+
+private:
+	std::vector<Entry>	entries_;	// the size is always a power of two
+	std::size_t			size_;
+};
+
+#endif
@@ -0,0 +1,110 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#include <method/polygon_grid_2d.h>
+#include <math/polygon2d.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+PolygonGrid2d::PolygonGrid2d(const std::vector<Polygon2d>& polygons) 
+	: polygons_(polygons)
+	, boxes_(polygons.size())
+{
+	xmin_ = ymin_ = FLT_MAX;
+	xmax_ = ymax_ = -FLT_MAX;
+	for (std::size_t i = 0; i < polygons.size(); ++i) {
+		Box& box = boxes_[i];
+		box.xmin = box.ymin = FLT_MAX;
+		box.xmax = box.ymax = -FLT_MAX;
+		for (std::size_t j = 0; j < polygons[i].size(); ++j) {
+			const vec2& p = polygons[i][j];
+			box.xmin = std::min(box.xmin, p.x);	box.xmax = std::max(box.xmax, p.x);
+			box.ymin = std::min(box.ymin, p.y);	box.ymax = std::max(box.ymax, p.y);
+		}
+		xmin_ = std::min(xmin_, box.xmin);	xmax_ = std::max(xmax_, box.xmax);
+		ymin_ = std::min(ymin_, box.ymin);	ymax_ = std::max(ymax_, box.ymax);
+	}
+
+	// about 4 polygons per cell in average
+	res_ = std::max(1, static_cast<int>(std::ceil(std::sqrt(polygons.size() / 4.0))));
+	cell_width_ = std::max((xmax_ - xmin_) / res_, FLT_MIN);
+	cell_height_ = std::max((ymax_ - ymin_) / res_, FLT_MIN);
+	cells_.resize(res_ * res_);
+	for (std::size_t i = 0; i < polygons.size(); ++i) {
+		const Box& box = boxes_[i];
+		if (box.xmin > box.xmax)	// empty polygon
+			continue;
+		int x0 = index_x(box.xmin), x1 = index_x(box.xmax);
+		int y0 = index_y(box.ymin), y1 = index_y(box.ymax);
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x)
+				cells_[y * res_ + x].push_back(static_cast<int>(i));
+		}
+	}
+}
+
+
+int PolygonGrid2d::index_x(float x) const { 
+	return std::min(static_cast<int>((x - xmin_) / cell_width_), res_ - 1); 
+}
+
+
+int PolygonGrid2d::index_y(float y) const { 
+	return std::min(static_cast<int>((y - ymin_) / cell_height_), res_ - 1); 
+}
+
+
+void PolygonGrid2d::locate(const vec2& q, std::vector<int>& result) const {
+	result.clear();
+	if (q.x < xmin_ || q.x > xmax_ || q.y < ymin_ || q.y > ymax_)
+		return;
+
+	const std::vector<int>& candidates = cells_[index_y(q.y) * res_ + index_x(q.x)];
+	for (std::size_t i = 0; i < candidates.size(); ++i) {
+		int id = candidates[i];
+		const Box& box = boxes_[id];
+		if (q.x < box.xmin || q.x > box.xmax || q.y < box.ymin || q.y > box.ymax)
+			continue;
+		if (Geom::point_is_in_polygon(polygons_[id], q))
+			result.push_back(id);
+	}
+}
+
+
+void PolygonGrid2d::overlapping(float xmin, float ymin, float xmax, float ymax, std::vector<int>& result) const {
+	result.clear();
+	if (xmax < xmin_ || xmin > xmax_ || ymax < ymin_ || ymin > ymax_)
+		return;
+
+	int x0 = index_x(std::max(xmin, xmin_)), x1 = index_x(std::min(xmax, xmax_));
+	int y0 = index_y(std::max(ymin, ymin_)), y1 = index_y(std::min(ymax, ymax_));
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			const std::vector<int>& candidates = cells_[y * res_ + x];
+			for (std::size_t i = 0; i < candidates.size(); ++i) {
+				const Box& box = boxes_[candidates[i]];
+				if (xmax < box.xmin || xmin > box.xmax || ymax < box.ymin || ymin > box.ymax)
+					continue;
+				result.push_back(candidates[i]);
+			}
+		}
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+}
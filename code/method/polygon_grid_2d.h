@@ -0,0 +1,57 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef _POLYGON_GRID_2D_H_
+#define _POLYGON_GRID_2D_H_
+
+#include <method/method_common.h>
+#include <math/math_types.h>
+
+#include <vector>
+
+
+// A uniform 2D grid over a set of polygons (e.g., the facets on a plane in its 2D coordinate 
+// system). Each cell records the polygons whose bounding boxes overlap it, so the polygons 
+// containing a point (or overlapping a box) can be found without testing all the polygons.
+// NOTE: the polygons are not copied and they must be kept alive with the grid.
+class METHOD_API PolygonGrid2d
+{
+public:
+	PolygonGrid2d(const std::vector<Polygon2d>& polygons);
+
+	// collects (in increasing order) the indices of the polygons containing 'q'
+	void locate(const vec2& q, std::vector<int>& result) const;
+
+	// collects (in increasing order) the indices of the polygons whose bounding boxes overlap the box
+	void overlapping(float xmin, float ymin, float xmax, float ymax, std::vector<int>& result) const;
+
+private:
+	// NOTE: only for coordinates within the bounding box of the polygons
+	int index_x(float x) const;
+	int index_y(float y) const;
+
+private:
+	struct Box { float xmin, ymin, xmax, ymax; };
+
+	const std::vector<Polygon2d>&	polygons_;
+	std::vector<Box>				boxes_;
+	float xmin_, ymin_, xmax_, ymax_;
+	float cell_width_, cell_height_;
+	int   res_;
+	std::vector< std::vector<int> >	cells_;
+};
+
+#endif
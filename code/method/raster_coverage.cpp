@@ -0,0 +1,191 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#include <method/raster_coverage.h>
+#include <model/point_set.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+namespace {
+
+	const float infinity = 1e20f;
+
+	// the 1D squared distance transform of a sampled function (Felzenszwalb and Huttenlocher, 2012).
+	// v and z are the workspace (of sizes n and n + 1).
+	void distance_transform(const float* f, int n, float* d, int* v, float* z) {
+		int k = 0;
+		v[0] = 0;
+		z[0] = -infinity;
+		z[1] = infinity;
+		for (int q = 1; q < n; ++q) {
+			float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+			while (s <= z[k]) {
+				--k;
+				s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+			}
+			++k;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = infinity;
+		}
+
+		k = 0;
+		for (int q = 0; q < n; ++q) {
+			while (z[k + 1] < q)
+				++k;
+			d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+		}
+	}
+
+	// the squared distances (in cells) from each cell of a w x h grid to the nearest cell whose value 
+	// is 'target'
+	void distance_transform(const std::vector<unsigned char>& grid, unsigned char target, int w, int h, std::vector<float>& dist) {
+		dist.resize(grid.size());
+		for (std::size_t i = 0; i < grid.size(); ++i)
+			dist[i] = (grid[i] == target) ? 0.0f : infinity;
+
+		int n = std::max(w, h);
+		std::vector<float> f(n), d(n), z(n + 1);
+		std::vector<int> v(n);
+
+		// the columns
+		for (int x = 0; x < w; ++x) {
+			for (int y = 0; y < h; ++y)
+				f[y] = dist[y * w + x];
+			distance_transform(&f[0], h, &d[0], &v[0], &z[0]);
+			for (int y = 0; y < h; ++y)
+				dist[y * w + x] = d[y];
+		}
+
+		// the rows
+		for (int y = 0; y < h; ++y) {
+			float* row = &dist[y * w];
+			std::copy(row, row + w, f.begin());
+			distance_transform(&f[0], w, row, &v[0], &z[0]);
+		}
+	}
+
+}
+
+
+void RasterCoverage::covered_areas(
+	const PointSet* pset,
+	const std::vector<unsigned int>& point_indices,
+	const Plane3d& plane,
+	float spacing,
+	float radius,
+	const std::vector<Polygon2d>& regions,
+	std::vector<double>& areas)
+{
+	areas.assign(regions.size(), 0.0);
+	if (point_indices.empty() || regions.empty())
+		return;
+
+	const std::vector<vec3>& points = pset->points();
+	std::vector<vec2> pts(point_indices.size());
+	float xmin = FLT_MAX, ymin = FLT_MAX, xmax = -FLT_MAX, ymax = -FLT_MAX;
+	for (std::size_t i = 0; i < point_indices.size(); ++i) {
+		const vec2& q = plane.to_2d(points[point_indices[i]]);
+		pts[i] = q;
+		xmin = std::min(xmin, q.x);	xmax = std::max(xmax, q.x);
+		ymin = std::min(ymin, q.y);	ymax = std::max(ymax, q.y);
+	}
+
+	// the cells are not smaller than the spacing, and the grid is limited to about 16M cells. The 
+	// border is wide enough for the dilation, so the erosion never reaches the outside of the grid.
+	const double max_cells = 16.0 * 1024 * 1024;
+	double cell = std::max(static_cast<double>(spacing), 1e-6);
+	double extent = std::max(xmax - xmin, ymax - ymin) + 2.0 * radius;
+	if ((extent / cell) * (extent / cell) > max_cells)
+		cell = extent / std::sqrt(max_cells);
+	int border = static_cast<int>(std::ceil(radius / cell)) + 1;
+	int w = static_cast<int>((xmax - xmin) / cell) + 1 + 2 * border;
+	int h = static_cast<int>((ymax - ymin) / cell) + 1 + 2 * border;
+	double x0 = xmin - border * cell;
+	double y0 = ymin - border * cell;
+
+	std::vector<unsigned char> occupied(static_cast<std::size_t>(w) * h, 0);
+	for (std::size_t i = 0; i < pts.size(); ++i) {
+		int x = std::min(static_cast<int>((pts[i].x - x0) / cell), w - 1);
+		int y = std::min(static_cast<int>((pts[i].y - y0) / cell), h - 1);
+		occupied[y * w + x] = 1;
+	}
+
+	// closing: dilation (within 'radius' of an occupied cell) followed by erosion (farther than 
+	// 'radius' from any cell left empty by the dilation)
+	const float sqr_radius = static_cast<float>((radius / cell) * (radius / cell));
+	std::vector<float> dist;
+	distance_transform(occupied, 1, w, h, dist);
+	for (std::size_t i = 0; i < occupied.size(); ++i)
+		occupied[i] = (dist[i] <= sqr_radius) ? 1 : 0;
+	distance_transform(occupied, 0, w, h, dist);
+	for (std::size_t i = 0; i < occupied.size(); ++i)
+		occupied[i] = (dist[i] > sqr_radius) ? 1 : 0;
+
+	// the number of covered cells before each cell of a row, so a span is counted in constant time
+	std::vector<unsigned int> prefix(static_cast<std::size_t>(w + 1) * h);
+	for (int y = 0; y < h; ++y) {
+		unsigned int* row = &prefix[static_cast<std::size_t>(y) * (w + 1)];
+		row[0] = 0;
+		for (int x = 0; x < w; ++x)
+			row[x + 1] = row[x] + occupied[y * w + x];
+	}
+
+	// the cells are sampled at their centers, and the spans of each row inside a region are given 
+	// by the crossings of the region's edges (even-odd rule, same as Geom::point_is_in_polygon())
+	const double cell_area = cell * cell;
+	std::vector<double> crossings;
+	for (std::size_t r = 0; r < regions.size(); ++r) {
+		const Polygon2d& region = regions[r];
+		std::size_t n = region.size();
+		if (n < 3)
+			continue;
+
+		double rymin = DBL_MAX, rymax = -DBL_MAX;
+		for (std::size_t i = 0; i < n; ++i) {
+			rymin = std::min(rymin, static_cast<double>(region[i].y));
+			rymax = std::max(rymax, static_cast<double>(region[i].y));
+		}
+		int row_begin = std::max(0, static_cast<int>(std::ceil((rymin - y0) / cell - 0.5)));
+		int row_end = std::min(h - 1, static_cast<int>(std::floor((rymax - y0) / cell - 0.5)));
+
+		std::size_t count = 0;
+		for (int y = row_begin; y <= row_end; ++y) {
+			double py = y0 + (y + 0.5) * cell;
+			crossings.clear();
+			for (std::size_t i = 0, j = n - 1; i < n; j = i, ++i) {
+				const vec2& u0 = region[i];
+				const vec2& u1 = region[j];
+				if ((u0.y <= py && py < u1.y) || (u1.y <= py && py < u0.y))
+					crossings.push_back(u0.x + (py - u0.y) * (u1.x - u0.x) / (u1.y - u0.y));
+			}
+			std::sort(crossings.begin(), crossings.end());
+
+			const unsigned int* row = &prefix[static_cast<std::size_t>(y) * (w + 1)];
+			for (std::size_t i = 0; i + 1 < crossings.size(); i += 2) {
+				// the cells whose centers are in [crossings[i], crossings[i + 1])
+				int a = std::max(0, static_cast<int>(std::ceil((crossings[i] - x0) / cell - 0.5)));
+				int b = std::min(w, static_cast<int>(std::ceil((crossings[i + 1] - x0) / cell - 0.5)));
+				if (a < b)
+					count += row[b] - row[a];
+			}
+		}
+		areas[r] = count * cell_area;
+	}
+}
@@ -0,0 +1,49 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef _RASTER_COVERAGE_H_
+#define _RASTER_COVERAGE_H_
+
+#include <method/method_common.h>
+#include <math/math_types.h>
+
+#include <vector>
+
+
+class PointSet;
+
+// Estimates the area covered by the points on a plane using a 2D occupancy grid (a fast 
+// alternative to AlphaShapeMesh::covered_areas()). The projected points are rasterized into 
+// cells of size 'spacing', and the occupied cells are closed (i.e., dilated and then eroded) 
+// by 'radius', which fills the gaps smaller than the alpha shape would without growing the 
+// outline of the points. The covered area of a region is then the area of the covered cells 
+// whose centers lie in the region.
+class METHOD_API RasterCoverage
+{
+public:
+	// computes the areas of the 2D regions (in the coordinate system of 'plane') covered by the points
+	static void covered_areas(
+		const PointSet* pset,
+		const std::vector<unsigned int>& point_indices,
+		const Plane3d& plane,
+		float spacing,
+		float radius,
+		const std::vector<Polygon2d>& regions,
+		std::vector<double>& areas
+	);
+};
+
+#endif
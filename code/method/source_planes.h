@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------------
+ * Copyright (C) 2017 Liangliang Nan <liangliang.nan@gmail.com>
+ * https://3d.bk.tudelft.nl/liangliang/
+ *
+ * This file is part of PolyFit. If it is useful in your research/work,
+ * I would be grateful if you show your appreciation by citing it:
+ *
+ *     Liangliang Nan and Peter Wonka.
+ *     PolyFit: Polygonal Surface Reconstruction from Point Clouds.
+ *     ICCV 2017.
+ *
+ *  For more information:
+ *  https://3d.bk.tudelft.nl/liangliang/publications/2017/polyfit/polyfit.html
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef _SOURCE_PLANES_H_
+#define _SOURCE_PLANES_H_
+
+#include <cstddef>
+#include <cstdint>
+
+
+// The supporting planes from which an edge (N = 2) or a vertex (N = 3) of the candidate faces is 
+// computed. A plane is denoted by its id (i.e., its index in the supporting planes of the hypothesis
+// generator). The ids are stored inline and kept in increasing order, so two records can be compared
+// (and hashed) directly to check if two edges/vertices are the same.
+template <unsigned int N>
+class SourcePlanes
+{
+public:
+	typedef std::uint32_t Id;
+	static const Id invalid_id = 0xffffffff;
+
+public:
+	SourcePlanes() {
+		for (unsigned int i = 0; i < N; ++i)
+			ids_[i] = invalid_id;
+	}
+
+	// copies the ids of a smaller record, e.g., a vertex on an edge is computed from the planes of 
+	// the edge (and the cutting plane).
+	template <unsigned int M>
+	explicit SourcePlanes(const SourcePlanes<M>& other) {
+		static_assert(M <= N, "the source record is larger than the target one");
+		for (unsigned int i = 0; i < N; ++i)
+			ids_[i] = (i < M) ? other[i] : invalid_id;
+	}
+
+	// the number of planes
+	std::size_t size() const {
+		std::size_t n = 0;
+		while (n < N && ids_[n] != invalid_id)
+			++n;
+		return n;
+	}
+	bool empty() const { return ids_[0] == invalid_id; }
+
+	bool contains(Id id) const {
+		for (unsigned int i = 0; i < N; ++i) {
+			if (ids_[i] == id)
+				return true;
+		}
+		return false;
+	}
+
+	// inserts a plane id (nothing changes if it already exists). Returns false if the record is full.
+	bool insert(Id id) {
+		if (contains(id))
+			return true;
+		if (ids_[N - 1] != invalid_id)
+			return false;
+
+		unsigned int i = N - 1;
+		for (; i > 0 && ids_[i - 1] > id; --i)	// the invalid ids are at the end
+			ids_[i] = ids_[i - 1];
+		ids_[i] = id;
+		return true;
+	}
+
+	Id operator[](std::size_t i) const { return ids_[i]; }
+
+	bool operator==(const SourcePlanes& rhs) const {
+		for (unsigned int i = 0; i < N; ++i) {
+			if (ids_[i] != rhs.ids_[i])
+				return false;
+		}
+		return true;
+	}
+	bool operator!=(const SourcePlanes& rhs) const { return !(*this == rhs); }
+
+	// lexicographical order
+	bool operator<(const SourcePlanes& rhs) const {
+		for (unsigned int i = 0; i < N; ++i) {
+			if (ids_[i] != rhs.ids_[i])
+				return ids_[i] < rhs.ids_[i];
+		}
+		return false;
+	}
+
+	std::size_t hash() const {
+		std::size_t h = 0;
+		for (unsigned int i = 0; i < N; ++i)
+			h ^= std::size_t(ids_[i]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		return h;
+	}
+
+	// to be used as the hash function of std::unordered_map/set
+	struct Hash {
+		std::size_t operator()(const SourcePlanes& planes) const { return planes.hash(); }
+	};
+
+private:
+	Id	ids_[N];
+};
+
+template <unsigned int N>
+const typename SourcePlanes<N>::Id SourcePlanes<N>::invalid_id;
+
+
+typedef SourcePlanes<2>		EdgeSourcePlanes;
+typedef SourcePlanes<3>		VertexSourcePlanes;
+
+#endif
@@ -43,30 +43,32 @@ namespace kdtree  {
 	// ******************
 	// global definitions
 	// ******************
-	bool     g_queryAll;
+	// NOTE: they are thread local, so different threads can query the tree concurrently
+	//       (see queryPosition(const Vector3D&, PQueue*)).
+	thread_local bool     g_queryAll;
 
 	//=====================================================
 	// global parameters for range search
 	//-----------------------------------------------------
-	float    g_queryOffsets[3];
-	Vector3D g_queryPosition;
+	thread_local float    g_queryOffsets[3];
+	thread_local Vector3D g_queryPosition;
 	//=====================================================
 
 	//=====================================================
 	// global parameters for line intersection search
 	//-----------------------------------------------------
-	bool     g_queryToLine;
-	Vector3D g_queryLine[2];
-	Vector3D g_queryLineDir;
+	thread_local bool     g_queryToLine;
+	thread_local Vector3D g_queryLine[2];
+	thread_local Vector3D g_queryLineDir;
 	//-----------------------------------------------------
 	// parameters for cylinder intersection
 	//-----------------------------------------------------
-	float g_queryMaxDist, g_queryMaxSqrDist, g_queryMaxSqrRange;
+	thread_local float g_queryMaxDist, g_queryMaxSqrDist, g_queryMaxSqrRange;
 	//-----------------------------------------------------
 	// parameters for cone intersection
 	//-----------------------------------------------------
-	Vector3D g_queryEye;
-	float g_queryMaxCosAngle, g_queryMaxTanAngle, g_queryMinSqrRange;
+	thread_local Vector3D g_queryEye;
+	thread_local float g_queryMaxCosAngle, g_queryMaxTanAngle, g_queryMinSqrRange;
 	//=====================================================
 
 	KdTree::KdTree(const Vector3D *positions, unsigned int nOfPositions, unsigned int maxBucketSize) {
@@ -126,6 +128,22 @@ namespace kdtree  {
 		}
 	}
 
+	void KdTree::queryPosition(const Vector3D &position, PQueue* queue) const {
+		g_queryAll          =   false;
+		g_queryOffsets[0]   =   0.0;
+		g_queryOffsets[1]   =   0.0;
+		g_queryOffsets[2]   =   0.0;
+		queue->init();
+		queue->insert(-1, FLT_MAX);
+		g_queryPosition     =   position;
+		float dist = BaseKdNode::computeBoxDistance(position, m_boundingBoxLowCorner, m_boundingBoxHighCorner);
+		m_root->queryNode(dist, queue);
+
+		if (queue->getMax().index == -1) {
+			queue->removeMax();
+		}
+	}
+
 	void KdTree::queryRange(const Vector3D &position, float maxSqrDistance, bool queryAll ) {
 		if (m_neighbours.size() == 0) {
 			if ( queryAll ) {
@@ -279,6 +279,19 @@ namespace kdtree  {
 		*/
 		void queryPosition(const Vector3D &position);
 
+		/**
+		* look for the nearest neighbours at <code>position</code> using the given queue as
+		* the working memory. The number of neighbours is the size of the queue, and the 
+		* neighbours found are left in the queue. The state of the tree is not changed, so 
+		* several threads can query the tree concurrently (each with its own queue).
+		*
+		* @param position
+		*			the position of the point to query with
+		* @param queue
+		*			the working memory (and the result) of the query
+		*/
+		void queryPosition(const Vector3D &position, PQueue* queue) const;
+
 		/**
 		* look for the nearest neighbours with a maximal squared distance <code>maxSqrDistance</code>. 
 		* If the set number of neighbours is smaller than the number of neighbours at this maximum distance, 
@@ -136,6 +136,47 @@ void KdTreeSearch::find_closest_K_points(
 }
 
 
+KdTreeSearch::Workspace::Workspace() : queue_(nil), k_(0) {
+}
+
+
+KdTreeSearch::Workspace::~Workspace() {
+	delete (kdtree::PQueue*)(queue_);
+}
+
+
+void KdTreeSearch::find_closest_K_points(
+	const vec3& p, unsigned int k, std::vector<unsigned int>& neighbors, std::vector<double>& squared_distances,
+	Workspace& workspace
+	)  const {
+		kdtree::PQueue* queue = (kdtree::PQueue*)(workspace.queue_);
+		if (!queue) {
+			queue = new kdtree::PQueue;
+			workspace.queue_ = queue;
+		}
+		if (workspace.k_ != k) {
+			queue->setSize(k);
+			workspace.k_ = k;
+		}
+
+		kdtree::Vector3D v3d( p.x, p.y, p.z );
+		get_tree(tree_)->queryPosition( v3d, queue );
+
+		unsigned int num = queue->getNofElements();
+		if (num == k) {
+			neighbors.resize(k);
+			squared_distances.resize(k);
+			for (int i=int(k)-1; i>=0; --i) {	// the farthest one is on the top
+				kdtree::Neighbour n = queue->getMax();
+				neighbors[i] = n.index;
+				squared_distances[i] = n.weight;
+				queue->removeMax();
+			}
+		} else
+			std::cerr << "less than " << k << " points found" << std::endl;
+}
+
+
 
 void KdTreeSearch::find_points_in_radius(
 	const vec3& p, double squared_radius, std::vector<unsigned int>& neighbors
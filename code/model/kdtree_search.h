@@ -60,6 +60,30 @@ public:
 		std::vector<unsigned int>& neighbors
 		) const;
 
+	// The working memory of a K-nearest neighbors search. The searches above share the working 
+	// memory of the tree, so they can't run concurrently. With a workspace for each thread, the
+	// search below is thread safe.
+	class MODEL_API Workspace {
+	public:
+		Workspace() ;
+		~Workspace() ;
+	private:
+		Workspace(const Workspace&) ;
+		Workspace& operator=(const Workspace&) ;
+
+		void*			queue_ ;
+		unsigned int	k_ ;
+		friend class KdTreeSearch ;
+	} ;
+
+	// NOTE: thread safe (if each thread has its own workspace), and *squared* distances are 
+	//       returned (in increasing order).
+	void find_closest_K_points(
+		const vec3& p, unsigned int k, 
+		std::vector<unsigned int>& neighbors, std::vector<double>& squared_distances,
+		Workspace& workspace
+		) const ;
+
 	//___________________ radius search __________________________
 
 	// fixed-radius kNN	search. Search for all points in the range.
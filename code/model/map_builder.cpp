@@ -59,7 +59,8 @@ struct FacetKey {
 	Map::Vertex* v3 ;
 } ;
 
-static std::set<FacetKey>* all_facet_keys ;
+// NOTE: thread local, so different threads can build different maps concurrently
+static thread_local std::set<FacetKey>* all_facet_keys = nil ;
 
 //_________________________________________________________
 
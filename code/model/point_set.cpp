@@ -75,6 +75,9 @@ void PointSet::delete_points(const std::vector<unsigned int>& indices) {
 	normals_ = new_normals;
 	colors_ = new_colors;
 	planar_qualities_ = new_planar_qualities;
+
+	for (std::size_t i = 0; i < groups_.size(); ++i)
+		groups_[i]->invalidate_moments();
 }
 
 std::vector<unsigned int> PointSet::idle_points() const {
@@ -96,14 +99,24 @@ std::vector<unsigned int> PointSet::idle_points() const {
 }
 
 
+const PointMoments3d& PointSet::moments(VertexGroup::Ptr g) {
+	if (g->moments_outdated()) {
+		PointMoments3d m;
+		for (std::size_t j = 0; j < g->size(); ++j) {
+			m.add_point(points_[g->at(j)]);
+		}
+		g->set_moments(m);
+	}
+	return g->moments();
+}
+
 void PointSet::fit_plane(VertexGroup::Ptr g) {
+	if (!g->plane_outdated())
+		return;
+
 	PrincipalAxes3d pca;
-	pca.begin();
-	for (std::size_t j = 0; j < g->size(); ++j) {
-		pca.add_point(points_[g->at(j)]);
-	}
-	pca.end();
+	pca.compute(moments(g));
 
 	Plane3d plane(pca.center(), pca.axis(2)); // eigen vectors have been normalized
-	g->set_plane(plane);
+	g->set_fitted_plane(plane);
 }
@@ -64,8 +64,13 @@ public:
 	// the points that don't belong to any vertex groups
 	std::vector<unsigned int> idle_points() const;
 
+	// fits the plane of a group from the (cached) moments of its points. Nothing is done if the 
+	// plane has been fitted and the group hasn't changed since then.
 	void fit_plane(VertexGroup::Ptr g);
 
+	// the moments of the points of a group (computed if the cache is outdated)
+	const PointMoments3d& moments(VertexGroup::Ptr g);
+
 	const Box3d& bbox() const;
 	void invalidate_bbox() { bbox_is_valid_ = false; }
 
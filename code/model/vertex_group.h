@@ -37,6 +37,8 @@ public:
 	VertexGroup(PointSet* pset = nil) 
 		: label_("unknown")
 		, point_set_(pset)
+		, moments_valid_(false)
+		, plane_fitted_(false)
 		, visible_(true)
 		, highlighted_(false)
 	{}
@@ -59,9 +61,51 @@ public:
 	const Color& color() const { return color_; }
 	void set_color(const Color& c) { color_ = c; }
 
-	void set_plane(const Plane3d& plane) { plane_ = plane; }
+	void set_plane(const Plane3d& plane) { plane_ = plane; plane_fitted_ = false; }
 	const Plane3d& plane() const { return plane_; }
 
+	// the moments of the points, cached for (re)fitting the plane in constant time (see 
+	// PointSet::fit_plane()). The cache (and the plane fitted from it) is outdated when the
+	// points change (see the membership mutators below).
+	const PointMoments3d& moments() const { return moments_; }
+	void set_moments(const PointMoments3d& m) { moments_ = m; moments_valid_ = true; }
+	bool moments_outdated() const { return !moments_valid_; }
+	void invalidate_moments() { moments_.clear(); moments_valid_ = false; plane_fitted_ = false; }
+
+	// sets the plane fitted from the current moments
+	void set_fitted_plane(const Plane3d& plane) { plane_ = plane; plane_fitted_ = true; }
+	// true if the plane has not been fitted from the current points
+	bool plane_outdated() const { return !plane_fitted_; }
+
+	// the membership mutators (hiding the ones of std::vector) invalidate the moments.
+	// NOTE: changing a point index in place (e.g., by operator[] or an iterator) doesn't, so 
+	//       invalidate_moments() must be called afterwards.
+	void push_back(unsigned int v) { std::vector<unsigned int>::push_back(v); invalidate_moments(); }
+	void pop_back() { std::vector<unsigned int>::pop_back(); invalidate_moments(); }
+	template <class InputIterator>
+	void insert(iterator pos, InputIterator first, InputIterator last) {
+		std::vector<unsigned int>::insert(pos, first, last);
+		invalidate_moments();
+	}
+	iterator insert(iterator pos, unsigned int v) {
+		iterator it = std::vector<unsigned int>::insert(pos, v);
+		invalidate_moments();
+		return it;
+	}
+	iterator erase(iterator pos) { iterator it = std::vector<unsigned int>::erase(pos); invalidate_moments(); return it; }
+	iterator erase(iterator first, iterator last) {
+		iterator it = std::vector<unsigned int>::erase(first, last);
+		invalidate_moments();
+		return it;
+	}
+	template <class InputIterator>
+	void assign(InputIterator first, InputIterator last) {
+		std::vector<unsigned int>::assign(first, last);
+		invalidate_moments();
+	}
+	void resize(std::size_t n) { std::vector<unsigned int>::resize(n); invalidate_moments(); }
+	void clear() { std::vector<unsigned int>::clear(); invalidate_moments(); }
+
 	const std::vector<unsigned int>& boundary() const { return boundary_; }
 	void set_boundary(const std::vector<unsigned int>& bd) { boundary_ = bd; }
 	
@@ -91,6 +135,10 @@ private:
 	Plane3d			plane_;
 	Color			color_;
 
+	PointMoments3d	moments_;
+	bool			moments_valid_;	// the moments are the ones of the current points
+	bool			plane_fitted_;	// the plane is fitted from the current points
+
 	std::vector<unsigned int>	boundary_;
 	std::vector<vec3>			facet_; 
 
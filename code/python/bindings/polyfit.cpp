@@ -93,16 +93,60 @@ void bind_map(py::module &m) {
 
 // Define Python bindings for the HypothesisGenerator class
 void bind_hypothesis_generator(py::module &m) {
-    // Bind the Adjacency type
-    py::bind_vector<HypothesisGenerator::Adjacency>(m, "Adjacency");
+    // Bind the SuperEdge and Adjacency types (the halfedges are not exposed)
+    py::class_<HypothesisGenerator::SuperEdge>(m, "SuperEdge")
+            .def("__len__", &HypothesisGenerator::SuperEdge::size, "Get the number of faces sharing the edge");
+    py::class_<HypothesisGenerator::Adjacency>(m, "Adjacency")
+            .def(py::init<>())
+            .def("__len__", &HypothesisGenerator::Adjacency::size, "Get the number of super edges")
+            .def("__getitem__", [](const HypothesisGenerator::Adjacency &adjacency, std::size_t i) {
+                     if (i >= adjacency.size())
+                         throw py::index_error();
+                     return adjacency[i];
+                 }, py::arg("i"), py::keep_alive<0, 1>(),  // the super edge is a view into the adjacency
+                 "Get a super edge");
+
+    // Bind the CoverageEstimator enum
+    py::enum_<HypothesisGenerator::CoverageEstimator>(m, "CoverageEstimator")
+            .value("ALPHA_SHAPE", HypothesisGenerator::ALPHA_SHAPE)
+            .value("RASTER", HypothesisGenerator::RASTER)
+            .export_values();
+
+    // Bind the CuttingMethod enum
+    py::enum_<HypothesisGenerator::CuttingMethod>(m, "CuttingMethod")
+            .value("INCREMENTAL_CUT", HypothesisGenerator::INCREMENTAL_CUT)
+            .value("LINE_ARRANGEMENT", HypothesisGenerator::LINE_ARRANGEMENT)
+            .export_values();
+
+    // Bind the PlaneDelta type (the changes of the planar segments for update())
+    py::class_<HypothesisGenerator::PlaneDelta>(m, "PlaneDelta")
+            .def(py::init<>())
+            .def_readwrite("added", &HypothesisGenerator::PlaneDelta::added, "The new segments")
+            .def_readwrite("removed", &HypothesisGenerator::PlaneDelta::removed, "The segments no longer used")
+            .def_readwrite("modified", &HypothesisGenerator::PlaneDelta::modified, "The segments whose points changed");
 
     // Bind the HypothesisGenerator class
     py::class_<HypothesisGenerator>(m, "HypothesisGenerator")
             .def(py::init<PointSet *>(), py::arg("pset"))
             .def("refine_planes", &HypothesisGenerator::refine_planes, "Refine planes")
             .def("generate", &HypothesisGenerator::generate, "Generate candidate faces")
+            .def("generate_kinetic", &HypothesisGenerator::generate_kinetic,
+                 "Generate candidate faces by the kinetic partition of the planes (for inputs with many planes)")
             .def("compute_confidences", &HypothesisGenerator::compute_confidences,
-                 py::arg("mesh"), py::arg("use_conficence") = false, "Compute confidences");
+                 py::arg("mesh"), py::arg("use_conficence") = false, "Compute confidences")
+            .def("update", &HypothesisGenerator::update,
+                 py::arg("mesh"), py::arg("delta"), py::arg("use_conficence") = false,
+                 "Update the candidate faces (and their confidences) for changed planar segments")
+            .def("set_num_threads", &HypothesisGenerator::set_num_threads,
+                 py::arg("num_threads"), "Set the number of threads (0: all hardware threads)")
+            .def("set_coverage_estimator", &HypothesisGenerator::set_coverage_estimator,
+                 py::arg("estimator"), "Set how the covered area of the candidate faces is estimated")
+            .def("set_cutting_method", &HypothesisGenerator::set_cutting_method,
+                 py::arg("method"), "Set how the proxy faces are cut into candidate faces")
+            .def("save_candidates", &HypothesisGenerator::save_candidates, py::arg("mesh"), py::arg("file_name"),
+                 "Save the candidate faces (with their confidences) and the planar segments to a binary file")
+            .def("load_candidates", &HypothesisGenerator::load_candidates, py::arg("file_name"),
+                 "Load the candidate faces saved by save_candidates() (ready for the face selection)");
 }
 
 
@@ -113,6 +157,13 @@ void bind_face_selection(py::module &m) {
             .value("SCIP", LinearProgramSolver::SCIP)
             .export_values();
 
+    // Bind the InitialSolution enum
+    py::enum_<FaceSelection::InitialSolution>(m, "InitialSolution")
+            .value("NONE", FaceSelection::NONE)
+            .value("GREEDY", FaceSelection::GREEDY)
+            .value("LP_ROUNDING", FaceSelection::LP_ROUNDING)
+            .export_values();
+
     // Bind the FaceSelection class
     py::class_<FaceSelection>(m, "FaceSelection")
             .def(py::init<PointSet *, Map *>(), py::arg("point_cloud"), py::arg("mesh"))
@@ -123,6 +174,20 @@ void bind_face_selection(py::module &m) {
                  py::arg("model_coverage") = 0.27f,
                  py::arg("model_complexity") = 0.3f,
                  "Optimization (i.e., face selection)"
+            )
+            .def("set_num_threads", &FaceSelection::set_num_threads,
+                 py::arg("num_threads"), "Set the number of threads for the independent parts (0: all hardware threads)")
+            .def("set_initial_solution", &FaceSelection::set_initial_solution,
+                 py::arg("initial_solution"), "Set the heuristic giving the solver an initial closed surface")
+            .def("formulate", &FaceSelection::formulate, py::arg("generator"),
+                 "Formulate the face selection once for multiple select() with different weights")
+            .def("select", &FaceSelection::select,
+                 py::arg("solver_name") = LinearProgramSolver::SCIP,
+                 py::arg("data_fitting") = 0.43f,
+                 py::arg("model_coverage") = 0.27f,
+                 py::arg("model_complexity") = 0.3f,
+                 py::return_value_policy::take_ownership,
+                 "Select the faces for the weights (warm-started), returning a new mesh (the candidates are kept)"
             );
 }
 